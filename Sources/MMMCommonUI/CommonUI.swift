@@ -172,3 +172,11 @@ extension CGRect {
 		self.init(origin: .zero, size: size)
 	}
 }
+
+extension MMMViewReusePool {
+
+	/// A typed version of `dequeueView(of:shape:)`.
+	public func dequeue<View: UIView>(_ viewClass: View.Type, shape: String = "") -> View {
+		return dequeueView(of: viewClass, shape: shape) as! View
+	}
+}
@@ -0,0 +1,431 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+/// The geometry behind `MMMCollectionViewLayout`: frames of items arranged into a list, a grid or a masonry
+/// for the given width, stored in contiguous arrays. Only needs CoreGraphics types, so can be used and tested
+/// separately from collection views.
+///
+/// Sections are laid out one after another. In all the arrangements the top edges of the items never go up
+/// as the index grows (for masonry it's because every next item goes to the shortest column), so together with
+/// running maximums of the bottom edges, the items intersecting any rect are found via a binary search
+/// and a short scan instead of checking every item.
+public final class MMMCollectionLayoutGeometry {
+
+	public enum Arrangement: Equatable {
+		/// One item per row, each with its own height.
+		case list
+		/// Rows of `columns` items of equal width, every row as tall as its tallest item.
+		case grid(columns: Int)
+		/// Columns of equal width, every item goes into the shortest column.
+		case masonry(columns: Int)
+	}
+
+	public let arrangement: Arrangement
+	public let width: CGFloat
+	/// Applied around the items of every section.
+	public let sectionInsets: UIEdgeInsets
+	/// Horizontal space between columns.
+	public let itemSpacing: CGFloat
+	/// Vertical space between rows (or items in the same column for masonry).
+	public let lineSpacing: CGFloat
+
+	public init(arrangement: Arrangement, width: CGFloat, sectionInsets: UIEdgeInsets, itemSpacing: CGFloat, lineSpacing: CGFloat) {
+		self.arrangement = arrangement
+		self.width = width
+		self.sectionInsets = sectionInsets
+		self.itemSpacing = itemSpacing
+		self.lineSpacing = lineSpacing
+	}
+
+	public var numberOfColumns: Int {
+		switch arrangement {
+		case .list:
+			return 1
+		case let .grid(columns), let .masonry(columns):
+			return max(1, columns)
+		}
+	}
+
+	/// The width every item is laid out with, so the heights can be calculated for it.
+	public var itemWidth: CGFloat {
+		let columns = CGFloat(numberOfColumns)
+		return max(0, (width - sectionInsets.left - sectionInsets.right - itemSpacing * (columns - 1)) / columns)
+	}
+
+	// All the items of all the sections in a row.
+	private var heights = ContiguousArray<CGFloat>()
+	private var frames = ContiguousArray<CGRect>()
+	private var maxYs = ContiguousArray<CGFloat>()
+	// The flat index of the first item of every section.
+	private var sectionStarts: [Int] = []
+	private var sectionBottoms: [CGFloat] = []
+	// Masonry columns of the last section, so items can be appended without starting over.
+	private var lastColumnBottoms: [CGFloat] = []
+
+	public var numberOfSections: Int { return sectionStarts.count }
+
+	public func numberOfItems(inSection section: Int) -> Int {
+		return (section + 1 < sectionStarts.count ? sectionStarts[section + 1] : frames.count) - sectionStarts[section]
+	}
+
+	public var contentHeight: CGFloat { return sectionBottoms.last ?? 0 }
+
+	/// Replaces all the items with the given heights per section.
+	public func setHeights(_ sections: [[CGFloat]]) {
+		heights.removeAll(keepingCapacity: true)
+		sectionStarts.removeAll(keepingCapacity: true)
+		for section in sections {
+			sectionStarts.append(heights.count)
+			heights.append(contentsOf: section)
+		}
+		frames = ContiguousArray(repeating: .zero, count: heights.count)
+		maxYs = ContiguousArray(repeating: 0, count: heights.count)
+		sectionBottoms = [CGFloat](repeating: 0, count: sectionStarts.count)
+		layout(fromSection: 0, item: 0)
+	}
+
+	/// Adds items with the given heights to the end of the last section, laying out only them.
+	public func appendHeights(_ newHeights: [CGFloat]) {
+		guard let lastStart = sectionStarts.last else {
+			setHeights([newHeights])
+			return
+		}
+		let first = heights.count - lastStart
+		heights.append(contentsOf: newHeights)
+		frames.append(contentsOf: repeatElement(.zero, count: newHeights.count))
+		maxYs.append(contentsOf: repeatElement(0, count: newHeights.count))
+		layout(fromSection: sectionStarts.count - 1, item: first, appending: true)
+	}
+
+	/// Changes heights of the given items, laying out only the ones that could be affected.
+	public func setHeights(_ changes: [(section: Int, item: Int, height: CGFloat)]) {
+		var first: (section: Int, item: Int)?
+		for change in changes {
+			heights[sectionStarts[change.section] + change.item] = change.height
+			if let f = first, (f.section, f.item) <= (change.section, change.item) { continue }
+			first = (change.section, change.item)
+		}
+		if let first = first {
+			layout(fromSection: first.section, item: first.item)
+		}
+	}
+
+	public func frame(section: Int, item: Int) -> CGRect {
+		return frames[sectionStarts[section] + item]
+	}
+
+	/// Calls the block for every item intersecting the given rect, in the order of sections and items.
+	public func forEachItem(in rect: CGRect, _ block: (_ section: Int, _ item: Int, _ frame: CGRect) -> Void) {
+
+		// The first item that can reach the rect: the running maximums of the bottom edges are sorted.
+		var lo = 0, hi = maxYs.count
+		while lo < hi {
+			let mid = (lo + hi) / 2
+			if maxYs[mid] <= rect.minY {
+				lo = mid + 1
+			} else {
+				hi = mid
+			}
+		}
+
+		var section = sectionIndex(forItemAt: lo)
+		var i = lo
+		// The top edges are sorted, so nothing further can intersect the rect once they are below it.
+		while i < frames.count && frames[i].minY < rect.maxY {
+			while section + 1 < sectionStarts.count && sectionStarts[section + 1] <= i {
+				section += 1
+			}
+			let frame = frames[i]
+			if frame.intersects(rect) {
+				block(section, i - sectionStarts[section], frame)
+			}
+			i += 1
+		}
+	}
+
+	private func sectionIndex(forItemAt index: Int) -> Int {
+		// The last section starting at or before the index.
+		var lo = 0, hi = sectionStarts.count
+		while lo < hi {
+			let mid = (lo + hi) / 2
+			if sectionStarts[mid] <= index {
+				lo = mid + 1
+			} else {
+				hi = mid
+			}
+		}
+		return max(0, lo - 1)
+	}
+
+	private func columnX(_ column: Int, itemWidth: CGFloat) -> CGFloat {
+		return sectionInsets.left + CGFloat(column) * (itemWidth + itemSpacing)
+	}
+
+	/// Lays out everything starting from the given item, which is the only place frames are calculated.
+	private func layout(fromSection firstSection: Int, item firstItem: Int, appending: Bool = false) {
+
+		let columns = numberOfColumns
+		let w = itemWidth
+
+		// The first item that has actually been laid out again.
+		var firstChanged = frames.count
+
+		for section in firstSection..<sectionStarts.count {
+
+			let start = sectionStarts[section]
+			let count = numberOfItems(inSection: section)
+			let top = (section == 0 ? 0 : sectionBottoms[section - 1]) + sectionInsets.top
+			var bottom = top
+
+			var item = (section == firstSection) ? firstItem : 0
+
+			switch arrangement {
+
+			case .list, .grid:
+				// Restarting from the beginning of the row the item is in.
+				item -= item % columns
+				firstChanged = min(firstChanged, start + item)
+				var y = item == 0 ? top : frames[start + item - 1].maxY + lineSpacing
+				while item < count {
+					let rowEnd = min(item + columns, count)
+					var rowHeight: CGFloat = 0
+					for i in item..<rowEnd {
+						rowHeight = max(rowHeight, heights[start + i])
+					}
+					for i in item..<rowEnd {
+						frames[start + i] = CGRect(x: columnX(i - item, itemWidth: w), y: y, width: w, height: rowHeight)
+					}
+					// The same as when restarting from the previous frame, so results do not depend on where layout starts.
+					y = (y + rowHeight) + lineSpacing
+					item = rowEnd
+				}
+				if count > 0 {
+					bottom = frames[start + count - 1].maxY
+				}
+
+			case .masonry:
+				var columnBottoms: [CGFloat]
+				if appending && section == sectionStarts.count - 1 && lastColumnBottoms.count == columns {
+					// The columns are where the previous layout has left them.
+					columnBottoms = lastColumnBottoms
+				} else {
+					// Where every column was before the item is not stored, so starting over.
+					item = 0
+					columnBottoms = [CGFloat](repeating: top, count: columns)
+				}
+				firstChanged = min(firstChanged, start + item)
+				while item < count {
+					var column = 0
+					for c in 1..<columns where columnBottoms[c] < columnBottoms[column] {
+						column = c
+					}
+					let h = heights[start + item]
+					frames[start + item] = CGRect(x: columnX(column, itemWidth: w), y: columnBottoms[column], width: w, height: h)
+					columnBottoms[column] += h + lineSpacing
+					item += 1
+				}
+				if count > 0 {
+					bottom = columnBottoms.max()! - lineSpacing
+				}
+				if section == sectionStarts.count - 1 {
+					lastColumnBottoms = columnBottoms
+				}
+			}
+
+			sectionBottoms[section] = bottom + sectionInsets.bottom
+		}
+
+		// The running maximums of the bottom edges.
+		var runningMax: CGFloat = firstChanged > 0 ? maxYs[firstChanged - 1] : 0
+		for i in firstChanged..<frames.count {
+			runningMax = max(runningMax, frames[i].maxY)
+			maxYs[i] = runningMax
+		}
+	}
+}
+
+public protocol MMMCollectionViewLayoutDelegate: AnyObject {
+	/// The height of the item when it's laid out with the given width.
+	func collectionView(
+		_ collectionView: UICollectionView,
+		layout: MMMCollectionViewLayout,
+		heightForItemAt indexPath: IndexPath,
+		width: CGFloat
+	) -> CGFloat
+}
+
+/// A collection view layout arranging items into a list, a grid or a masonry with all the frames precomputed
+/// by `MMMCollectionLayoutGeometry`, so visible items are found without going through all of them.
+///
+/// Heights of the items are asked from the delegate only when the layout is rebuilt (e.g. when the width changes),
+/// for appended items and for items passed to `invalidateHeights(at:)`. Items inserted at the end
+/// of the last section are laid out incrementally, other updates rebuild the layout.
+public final class MMMCollectionViewLayout: UICollectionViewLayout {
+
+	public weak var delegate: MMMCollectionViewLayoutDelegate?
+
+	public var arrangement: MMMCollectionLayoutGeometry.Arrangement = .list { didSet { invalidateEverything() } }
+	public var sectionInsets: UIEdgeInsets = .zero { didSet { invalidateEverything() } }
+	public var itemSpacing: CGFloat = 0 { didSet { invalidateEverything() } }
+	public var lineSpacing: CGFloat = 0 { didSet { invalidateEverything() } }
+
+	private var geometry: MMMCollectionLayoutGeometry?
+	private var needsRebuild = true
+	private var countsChanged = false
+	private var resized: [IndexPath] = []
+	// True, if the geometry was rebuilt after the most recent invalidation, so prepare(forCollectionViewUpdates:)
+	// does not have to do it again for the same batch of updates.
+	private var rebuiltSinceInvalidation = false
+
+	private func invalidateEverything() {
+		needsRebuild = true
+		invalidateLayout()
+	}
+
+	/// Asks the delegate for new heights of the given items and lays out only the ones that could be affected.
+	public func invalidateHeights(at indexPaths: [IndexPath]) {
+		let context = UICollectionViewLayoutInvalidationContext()
+		context.invalidateItems(at: indexPaths)
+		invalidateLayout(with: context)
+	}
+
+	public override func invalidateLayout(with context: UICollectionViewLayoutInvalidationContext) {
+		super.invalidateLayout(with: context)
+		rebuiltSinceInvalidation = false
+		if context.invalidateEverything {
+			needsRebuild = true
+		} else if context.invalidateDataSourceCounts {
+			countsChanged = true
+		}
+		if let indexPaths = context.invalidatedItemIndexPaths {
+			resized.append(contentsOf: indexPaths)
+		}
+	}
+
+	private func height(for indexPath: IndexPath, width: CGFloat, in collectionView: UICollectionView) -> CGFloat {
+		return delegate?.collectionView(collectionView, layout: self, heightForItemAt: indexPath, width: width) ?? width
+	}
+
+	private func rebuild(_ collectionView: UICollectionView) {
+
+		let geometry = MMMCollectionLayoutGeometry(
+			arrangement: arrangement,
+			width: collectionView.bounds.width,
+			sectionInsets: sectionInsets,
+			itemSpacing: itemSpacing,
+			lineSpacing: lineSpacing
+		)
+		let width = geometry.itemWidth
+		geometry.setHeights((0..<collectionView.numberOfSections).map { section in
+			(0..<collectionView.numberOfItems(inSection: section)).map { item in
+				height(for: IndexPath(item: item, section: section), width: width, in: collectionView)
+			}
+		})
+
+		self.geometry = geometry
+		needsRebuild = false
+		countsChanged = false
+		resized.removeAll()
+		rebuiltSinceInvalidation = true
+	}
+
+	public override func prepare() {
+
+		super.prepare()
+
+		guard let collectionView = collectionView else { return }
+
+		guard let geometry = geometry, !needsRebuild, geometry.width == collectionView.bounds.width else {
+			rebuild(collectionView)
+			return
+		}
+
+		if countsChanged {
+			countsChanged = false
+			// Only growing of the last section can be handled incrementally; prepare(forCollectionViewUpdates:)
+			// double checks that the items were actually appended.
+			let sections = collectionView.numberOfSections
+			let last = sections - 1
+			let unchanged = sections == geometry.numberOfSections
+				&& (0..<max(0, last)).allSatisfy { collectionView.numberOfItems(inSection: $0) == geometry.numberOfItems(inSection: $0) }
+			guard sections > 0, unchanged, collectionView.numberOfItems(inSection: last) >= geometry.numberOfItems(inSection: last) else {
+				rebuild(collectionView)
+				return
+			}
+			let width = geometry.itemWidth
+			let appended = (geometry.numberOfItems(inSection: last)..<collectionView.numberOfItems(inSection: last)).map {
+				height(for: IndexPath(item: $0, section: last), width: width, in: collectionView)
+			}
+			if !appended.isEmpty {
+				geometry.appendHeights(appended)
+			}
+		}
+
+		if !resized.isEmpty {
+			let width = geometry.itemWidth
+			geometry.setHeights(resized.map {
+				(section: $0.section, item: $0.item, height: height(for: $0, width: width, in: collectionView))
+			})
+			resized.removeAll()
+		}
+	}
+
+	public override func prepare(forCollectionViewUpdates updateItems: [UICollectionViewUpdateItem]) {
+
+		super.prepare(forCollectionViewUpdates: updateItems)
+
+		// prepare() has rebuilt everything for this batch already, e.g. because items were removed.
+		guard !rebuiltSinceInvalidation, let collectionView = collectionView, let geometry = geometry else { return }
+
+		let last = geometry.numberOfSections - 1
+		let appendedOnly = updateItems.allSatisfy { update in
+			guard update.updateAction == .insert, let indexPath = update.indexPathAfterUpdate else { return false }
+			// Appended items come after all the items that were there before.
+			return indexPath.section == last && indexPath.item >= geometry.numberOfItems(inSection: last) - updateItems.count
+		}
+		if !appendedOnly {
+			rebuild(collectionView)
+		}
+	}
+
+	public override var collectionViewContentSize: CGSize {
+		guard let geometry = geometry else { return .zero }
+		return CGSize(width: geometry.width, height: geometry.contentHeight)
+	}
+
+	private func attributes(section: Int, item: Int, frame: CGRect) -> UICollectionViewLayoutAttributes {
+		// Not caching these: the frames are looked up quickly anyway and a cache would grow with every item
+		// ever shown in a long list.
+		let attributes = UICollectionViewLayoutAttributes(forCellWith: IndexPath(item: item, section: section))
+		attributes.frame = frame
+		return attributes
+	}
+
+	public override func layoutAttributesForElements(in rect: CGRect) -> [UICollectionViewLayoutAttributes]? {
+		var result: [UICollectionViewLayoutAttributes] = []
+		geometry?.forEachItem(in: rect) { section, item, frame in
+			result.append(attributes(section: section, item: item, frame: frame))
+		}
+		return result
+	}
+
+	public override func layoutAttributesForItem(at indexPath: IndexPath) -> UICollectionViewLayoutAttributes? {
+		guard let geometry = geometry,
+			indexPath.section < geometry.numberOfSections,
+			indexPath.item < geometry.numberOfItems(inSection: indexPath.section)
+		else {
+			return nil
+		}
+		return attributes(
+			section: indexPath.section,
+			item: indexPath.item,
+			frame: geometry.frame(section: indexPath.section, item: indexPath.item)
+		)
+	}
+
+	public override func shouldInvalidateLayout(forBoundsChange newBounds: CGRect) -> Bool {
+		return newBounds.width != geometry?.width
+	}
+}
@@ -0,0 +1,169 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+/// Decides how long the crossfade should be when a loaded image replaces a placeholder, so the crossfades
+/// are not wasted on cells flying by or leaving the screen during fast scrolling.
+public struct MMMCrossfadePolicy {
+
+	/// The duration of a crossfade when nothing is scrolling.
+	public var duration: TimeInterval = 0.25
+
+	/// The scrolling speed (points per second) up to which the crossfade has its full duration.
+	/// Faster than that and it gets proportionally shorter...
+	public var slowVelocity: CGFloat = 300
+
+	/// ...until this speed, when it is skipped completely.
+	public var fastVelocity: CGFloat = 2500
+
+	/// Crossfades that would be shorter than this are skipped, as they would not be noticed anyway.
+	public var minDuration: TimeInterval = 0.08
+
+	/// The max number of crossfades running at the same time; the images are simply set beyond that.
+	public var maxConcurrentCrossfades: Int = 6
+
+	public init() {}
+
+	/// The duration of the crossfade for a view with the given visibility that is scrolled with the given speed
+	/// while `activeCrossfades` other crossfades are running. Zero means no crossfade.
+	public func duration(velocity: CGFloat, isVisible: Bool, activeCrossfades: Int) -> TimeInterval {
+
+		guard isVisible, activeCrossfades < maxConcurrentCrossfades else { return 0 }
+
+		let speed = abs(velocity)
+		guard speed > slowVelocity else { return duration }
+		guard speed < fastVelocity else { return 0 }
+
+		let t = Double((speed - slowVelocity) / (fastVelocity - slowVelocity))
+		let result = duration * (1 - t)
+		return result >= minDuration ? result : 0
+	}
+}
+
+/// Runs crossfades for `MMMLoadableImageView`s according to `MMMCrossfadePolicy`, looking at the scroll views
+/// the views are in and keeping the global count of crossfades in flight.
+///
+/// Should be used on the main thread only.
+public final class MMMCrossfadeCoordinator {
+
+	/// The instance used by `MMMLoadableImageView` by default.
+	public static let shared = MMMCrossfadeCoordinator()
+
+	public var policy: MMMCrossfadePolicy
+
+	/// The number of crossfades running now.
+	public private(set) var numberOfActiveCrossfades: Int = 0
+
+	/// The number of crossfades started so far, including the shortened ones. For diagnostics only.
+	public private(set) var numberOfCrossfades: Int = 0
+
+	/// The number of crossfades that were shorter than usual. For diagnostics only.
+	public private(set) var numberOfShortenedCrossfades: Int = 0
+
+	/// The number of crossfades that were skipped altogether. For diagnostics only.
+	public private(set) var numberOfSkippedCrossfades: Int = 0
+
+	public init(policy: MMMCrossfadePolicy = MMMCrossfadePolicy()) {
+		self.policy = policy
+	}
+
+	/// Sets the image of the given image view with a crossfade or without, depending on the policy.
+	public func setImage(_ image: UIImage?, on imageView: UIImageView) {
+
+		let duration = policy.duration(
+			velocity: velocity(around: imageView),
+			isVisible: isVisible(imageView),
+			activeCrossfades: numberOfActiveCrossfades
+		)
+		guard duration > 0 else {
+			numberOfSkippedCrossfades += 1
+			imageView.image = image
+			return
+		}
+
+		numberOfCrossfades += 1
+		if duration < policy.duration {
+			numberOfShortenedCrossfades += 1
+		}
+
+		numberOfActiveCrossfades += 1
+		UIView.transition(
+			with: imageView,
+			duration: duration,
+			options: [.beginFromCurrentState, .transitionCrossDissolve],
+			animations: {
+				imageView.image = image
+			},
+			completion: { [weak self] (_) in
+				imageView.image = image
+				self?.numberOfActiveCrossfades -= 1
+			}
+		)
+	}
+
+	private func isVisible(_ view: UIView) -> Bool {
+		guard let window = view.window, !view.isHidden, view.alpha > 0 else { return false }
+		return window.bounds.intersects(view.convert(view.bounds, to: nil))
+	}
+
+	/// The fastest speed among the scroll views the view is in (a carousel can be within a table, for example).
+	private func velocity(around view: UIView) -> CGFloat {
+		var result: CGFloat = 0
+		var superview = view.superview
+		while let v = superview {
+			if let scrollView = v as? UIScrollView {
+				result = max(result, velocity(of: scrollView))
+			}
+			superview = v.superview
+		}
+		return result
+	}
+
+	private final class Sample {
+		let offset: CGPoint
+		let time: CFTimeInterval
+		let velocity: CGFloat
+		init(offset: CGPoint, time: CFTimeInterval, velocity: CGFloat) {
+			self.offset = offset
+			self.time = time
+			self.velocity = velocity
+		}
+	}
+
+	private let samples = NSMapTable<UIScrollView, Sample>.weakToStrongObjects()
+
+	private func velocity(of scrollView: UIScrollView) -> CGFloat {
+
+		if scrollView.isTracking {
+			let v = scrollView.panGestureRecognizer.velocity(in: scrollView)
+			return hypot(v.x, v.y)
+		}
+
+		guard scrollView.isDecelerating else {
+			samples.removeObject(forKey: scrollView)
+			return 0
+		}
+
+		// The pan recognizer knows nothing about the deceleration, so estimating the speed from the offsets
+		// seen by the previous crossfades. Many images complete during a fling, so the samples are usually fresh.
+		let now = CACurrentMediaTime()
+		let offset = scrollView.contentOffset
+		let velocity: CGFloat
+		if let previous = samples.object(forKey: scrollView), now - previous.time < 0.25 {
+			let dt = now - previous.time
+			guard dt > 1.0 / 120 else {
+				// Within the same frame, the offset could not change yet.
+				return previous.velocity
+			}
+			velocity = hypot(offset.x - previous.offset.x, offset.y - previous.offset.y) / CGFloat(dt)
+		} else {
+			// Nothing recent to compare with; a deceleration is fast in the beginning, so erring on the side
+			// of skipping the crossfade.
+			velocity = policy.fastVelocity
+		}
+		samples.setObject(Sample(offset: offset, time: now, velocity: velocity), forKey: scrollView)
+
+		return velocity
+	}
+}
@@ -0,0 +1,236 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+/// Measures text for `MMMLayoutDescriptor`. Implementations must be safe to call from any thread.
+public protocol MMMTextMeasurer {
+	/// The size of the given text when laid out within `width` points, rounded up to whole pixels.
+	/// When `numberOfLines` is greater than zero, then the height should be limited by it.
+	func size(of text: String, font: UIFont, numberOfLines: Int, width: CGFloat) -> CGSize
+}
+
+/// The default text measurer based on `NSString` drawing extensions, which are thread-safe.
+public final class MMMStringDrawingTextMeasurer: MMMTextMeasurer {
+
+	private let scale: CGFloat
+
+	/// - Parameter scale: The pixel scale used to round the sizes up. Pass `UIScreen.main.scale` from the main thread.
+	public init(scale: CGFloat) {
+		self.scale = scale
+	}
+
+	public func size(of text: String, font: UIFont, numberOfLines: Int, width: CGFloat) -> CGSize {
+
+		let rect = (text as NSString).boundingRect(
+			with: CGSize(width: width, height: .greatestFiniteMagnitude),
+			options: [.usesLineFragmentOrigin, .usesFontLeading],
+			attributes: [.font: font],
+			context: nil
+		)
+
+		var height = rect.height
+		if numberOfLines > 0 {
+			height = min(height, font.lineHeight * CGFloat(numberOfLines))
+		}
+
+		return CGSize(
+			width: min(width, ceil(rect.width * scale) / scale),
+			height: ceil(height * scale) / scale
+		)
+	}
+}
+
+/// A declarative description of the content of a cell following the semantics of our layout primitives
+/// (`MMMStackContainer`, `MMMGridContainer`, `MMMPaddedView`), so its size can be calculated with frame math
+/// on any thread without instantiating views or running Auto Layout.
+///
+/// The calculations approximate what Auto Layout would do with the default priorities used by the primitives:
+/// - vertical stacks give all the width to every subview and sum up their heights;
+/// - horizontal stacks give views having fixed sizes their widths first and split the rest equally
+///   between the remaining (flexible) views;
+/// - grids have columns of equal width and rows as tall as their tallest views.
+public indirect enum MMMLayoutDescriptor {
+
+	/// A label with the given text and font, wrapping to multiple lines unless `numberOfLines` is positive.
+	case text(String, font: UIFont, numberOfLines: Int)
+
+	/// A view of a fixed size, like an icon.
+	case fixed(CGSize)
+
+	/// A view taking all the available width and the height proportional to it, like an image.
+	case aspect(heightToWidth: CGFloat)
+
+	/// See `MMMPaddedView`.
+	case padded(MMMLayoutDescriptor, insets: UIEdgeInsets)
+
+	/// See `MMMVerticalStackContainer`.
+	case verticalStack([MMMLayoutDescriptor], spacing: CGFloat, insets: UIEdgeInsets)
+
+	/// See `MMMHorizontalStackContainer`.
+	case horizontalStack([MMMLayoutDescriptor], spacing: CGFloat, insets: UIEdgeInsets)
+
+	/// See `MMMGridContainer.setSubviews(_:numberOfColumns:)`.
+	case grid(
+		[MMMLayoutDescriptor], numberOfColumns: Int,
+		horizontalSpacing: CGFloat, verticalSpacing: CGFloat, insets: UIEdgeInsets
+	)
+
+	/// The size of the content when it's given `width` points horizontally.
+	public func size(forWidth width: CGFloat, measurer: MMMTextMeasurer) -> CGSize {
+
+		let width = max(0, width)
+
+		switch self {
+
+		case let .text(text, font, numberOfLines):
+			return measurer.size(of: text, font: font, numberOfLines: numberOfLines, width: width)
+
+		case let .fixed(size):
+			return size
+
+		case let .aspect(ratio):
+			return CGSize(width: width, height: width * ratio)
+
+		case let .padded(content, insets):
+			let size = content.size(forWidth: width - insets.left - insets.right, measurer: measurer)
+			return CGSize(
+				width: size.width + insets.left + insets.right,
+				height: size.height + insets.top + insets.bottom
+			)
+
+		case let .verticalStack(items, spacing, insets):
+			let innerWidth = width - insets.left - insets.right
+			var maxWidth: CGFloat = 0
+			var height: CGFloat = 0
+			for (i, item) in items.enumerated() {
+				let size = item.size(forWidth: innerWidth, measurer: measurer)
+				maxWidth = max(maxWidth, size.width)
+				height += size.height + (i > 0 ? spacing : 0)
+			}
+			return CGSize(
+				width: maxWidth + insets.left + insets.right,
+				height: height + insets.top + insets.bottom
+			)
+
+		case let .horizontalStack(items, spacing, insets):
+			let innerWidth = width - insets.left - insets.right - spacing * CGFloat(max(0, items.count - 1))
+			let fixedWidth = items.reduce(CGFloat(0)) { total, item in
+				if case let .fixed(size) = item { return total + size.width } else { return total }
+			}
+			let flexibleCount = items.filter { if case .fixed = $0 { return false } else { return true } }.count
+			let flexibleWidth = flexibleCount > 0 ? max(0, innerWidth - fixedWidth) / CGFloat(flexibleCount) : 0
+			var totalWidth: CGFloat = 0
+			var height: CGFloat = 0
+			for (i, item) in items.enumerated() {
+				let size: CGSize
+				if case let .fixed(s) = item {
+					size = s
+				} else {
+					size = item.size(forWidth: flexibleWidth, measurer: measurer)
+				}
+				totalWidth += size.width + (i > 0 ? spacing : 0)
+				height = max(height, size.height)
+			}
+			return CGSize(
+				width: totalWidth + insets.left + insets.right,
+				height: height + insets.top + insets.bottom
+			)
+
+		case let .grid(items, numberOfColumns, horizontalSpacing, verticalSpacing, insets):
+			let columns = max(1, numberOfColumns)
+			let innerWidth = width - insets.left - insets.right
+			let columnWidth = max(0, innerWidth - horizontalSpacing * CGFloat(columns - 1)) / CGFloat(columns)
+			var height: CGFloat = 0
+			for row in stride(from: 0, to: items.count, by: columns) {
+				var rowHeight: CGFloat = 0
+				for item in items[row..<min(row + columns, items.count)] {
+					rowHeight = max(rowHeight, item.size(forWidth: columnWidth, measurer: measurer).height)
+				}
+				height += rowHeight + (row > 0 ? verticalSpacing : 0)
+			}
+			return CGSize(width: width, height: height + insets.top + insets.bottom)
+		}
+	}
+}
+
+/// Calculates heights of cells described via `MMMLayoutDescriptor` on background threads, so they can be known
+/// for the next rows before the table view asks for them.
+public final class MMMBackgroundCellSizer {
+
+	private let measurer: MMMTextMeasurer
+	private let maxConcurrency: Int
+	private let queue = DispatchQueue(label: "MMMBackgroundCellSizer", qos: .userInitiated)
+
+	/// - Parameters:
+	///   - measurer: Used for all the text in the descriptors, must be thread-safe.
+	///   - maxConcurrency: How many threads can be used for sizing at the same time; all the cores by default.
+	public init(measurer: MMMTextMeasurer, maxConcurrency: Int = ProcessInfo.processInfo.activeProcessorCount) {
+		self.measurer = measurer
+		self.maxConcurrency = max(1, maxConcurrency)
+	}
+
+	/// Heights of all the given descriptors for the given width, calculated in parallel on the current thread
+	/// and up to `maxConcurrency - 1` others.
+	public func heights(for descriptors: [MMMLayoutDescriptor], width: CGFloat) -> [CGFloat] {
+
+		var result = [CGFloat](repeating: 0, count: descriptors.count)
+		let chunks = min(maxConcurrency, descriptors.count)
+		guard chunks > 1 else {
+			for (i, d) in descriptors.enumerated() {
+				result[i] = d.size(forWidth: width, measurer: measurer).height
+			}
+			return result
+		}
+
+		// Every chunk writes its own range of the buffer, so no locking is needed.
+		let measurer = self.measurer
+		result.withUnsafeMutableBufferPointer { buffer in
+			DispatchQueue.concurrentPerform(iterations: chunks) { chunk in
+				let range = (descriptors.count * chunk / chunks)..<(descriptors.count * (chunk + 1) / chunks)
+				for i in range {
+					buffer[i] = descriptors[i].size(forWidth: width, measurer: measurer).height
+				}
+			}
+		}
+		return result
+	}
+
+	/// Calculates the heights on a background queue and calls the completion on the main one.
+	/// The completion is always called, the sizer is kept alive until then.
+	public func heights(
+		for descriptors: [MMMLayoutDescriptor],
+		width: CGFloat,
+		completion: @escaping ([CGFloat]) -> Void
+	) {
+		// Holding self strongly: there is no cycle here and dropping the work would leave the caller waiting.
+		queue.async {
+			let heights = self.heights(for: descriptors, width: width)
+			DispatchQueue.main.async {
+				completion(heights)
+			}
+		}
+	}
+
+	/// Calculates the heights of the rows with the given content hashes and descriptors (e.g. the next rows
+	/// to be displayed) in the background and stores them into the cache, so they can be used as exact estimates.
+	/// The width and the content size category are taken from the table view at the time of the call.
+	public func prefetchHeights(
+		_ rows: [(contentHash: UInt64, descriptor: MMMLayoutDescriptor)],
+		tableView: UITableView,
+		cache: MMMRowHeightCache
+	) {
+		let width = tableView.bounds.width
+		let category = tableView.traitCollection.preferredContentSizeCategory.rawValue
+
+		// No need to measure what is known already.
+		let missing = rows.filter { cache.height(forContentHash: $0.contentHash, width: width, contentSizeCategory: category) == 0 }
+		guard !missing.isEmpty else { return }
+
+		heights(for: missing.map { $0.descriptor }, width: width) { heights in
+			for (row, height) in zip(missing, heights) {
+				cache.setHeight(height, forContentHash: row.contentHash, width: width, contentSizeCategory: category)
+			}
+		}
+	}
+}
@@ -32,8 +32,16 @@ public final class MMMLoadableImageView: NonStoryboardableView {
 	// No reason to open this for changes at any time.
 	private let placeholderImage: UIImage?
 
+	private let mode: Mode
+
 	private var imageObserver: MMMLoadableObserver?
 
+	/// The image found in `MMMDecodedImageCache` for the current loadable, if it supports it.
+	private var cachedImage: UIImage?
+
+	/// The cache looked into for loadable images conforming to `MMMDecodedImageCacheSource`.
+	private let decodedImageCache = MMMDecodedImageCache.shared()
+
 	/// A loadable image this image view should display and track. Just set and forget.
 	/// (Well, think of the max size you would like this image view to have and set the corresponding constraints.)
 	public var image: MMMLoadableImage? {
@@ -41,6 +49,9 @@ public final class MMMLoadableImageView: NonStoryboardableView {
 			guard image !== oldValue else {
 				return
 			}
+			decodeRequest?.cancel()
+			decodeRequest = nil
+			decodedImage = nil
 			if let loadableImage = image {
 				imageObserver = MMMLoadableObserver(loadable: loadableImage) { [weak self] _ in
 					self?.update(animated: true)
@@ -48,18 +59,57 @@ public final class MMMLoadableImageView: NonStoryboardableView {
 			} else {
 				imageObserver = nil
 			}
+			// Showing the same image decoded for another view right away, if any...
+			cachedImage = nil
+			if let image = image, !image.isContentsAvailable, let key = cacheKey(for: image) {
+				cachedImage = decodedImageCache.image(for: key)
+			}
+			// (The cached image is displayed below, so the loadable catching up with it should not crossfade.)
+			displaysLoadedImage = (cachedImage != nil)
+			// ...but still syncing, so other observers of the loadable see it loaded as well. The cache sources
+			// look into the same cache in `doSync`, so this is cheap on a hit.
 			image?.syncIfNeeded()
 			update(animated: false)
 		}
 	}
 
+	/// When set, then loaded images are decompressed and downsampled to the size of the view in the background
+	/// before they are displayed, so the main thread does not have to decode them and the memory is not wasted
+	/// on the pixels the view cannot show. The size of the view is taken at the time the image is loaded,
+	/// the image is only decompressed if the view has not been laid out yet.
+	///
+	/// Off by default, `MMMImageDecoder.shared()` should be good for most cases.
+	public var decoder: MMMImageDecoder?
+
+	/// When enabled, then a shimmering placeholder (see `MMMShimmerView`) covers the view while the image is loading.
+	/// Off by default.
+	public var showsShimmer: Bool = false {
+		didSet {
+			update(animated: false)
+		}
+	}
+
+	private var shimmerView: MMMShimmerView?
+
+	/// Decides if the loaded image should crossfade over the placeholder and how long, so the crossfades are skipped
+	/// or shortened for views that are scrolled fast or are off screen already. Set to `nil` to always crossfade.
+	public var crossfadeCoordinator: MMMCrossfadeCoordinator? = .shared
+
+	/// YES, if the contents of the current loadable (or its cached version) is displayed already,
+	/// so a change of the loadable's image is an in-place upgrade (e.g. a progressive one) that should not crossfade.
+	private var displaysLoadedImage = false
+
+	private var decodeRequest: MMMImageDecoderRequest?
+	private var decodedImage: (source: UIImage, result: UIImage)?
+
 	// MARK: Init
 
-	// TODO: visually distinguish between 'loading' and 'failed to load' states, e.g. by using two placeholders or possibly using "shimmer"-kind animation.
+	// TODO: visually distinguish 'failed to load' state from the idle one, e.g. by using two placeholders (loading can use `showsShimmer`).
 	// TODO: this is where effects like shadows and corners can be added as well.
 	public init(placeholderImage: UIImage? = nil, mode: Mode = .fit) {
 
 		self.placeholderImage = placeholderImage
+		self.mode = mode
 
 		super.init()
 
@@ -116,25 +166,92 @@ public final class MMMLoadableImageView: NonStoryboardableView {
 
 	private func update(animated: Bool) {
 
+		defer { updateShimmer() }
+
 		guard let loadableImage = image else {
 			imageView.image = placeholderImage
 			return
 		}
 
 		if loadableImage.isContentsAvailable {
-			updateImage(with: loadableImage.image, animated: animated)
+			// Not storing anything in the cache here, the loadables that support it do so themselves.
+			updateLoadedImage(with: loadableImage.image, animated: animated && !displaysLoadedImage)
+		} else if let cachedImage = cachedImage {
+			updateImage(with: cachedImage)
+			displaysLoadedImage = true
 		} else {
 			assert(loadableImage.loadableState == .syncing || loadableImage.loadableState == .didFailToSync)
 			// TODO: currently we don't distinguish between loading and failed here, but would be better to so.
 			updateImage(with: placeholderImage)
+			displaysLoadedImage = false
 		}
 	}
 	
+	private func updateShimmer() {
+
+		let loading = image.map { !$0.isContentsAvailable && $0.loadableState == .syncing && cachedImage == nil } ?? false
+		guard showsShimmer && loading else {
+			shimmerView?.removeFromSuperview()
+			shimmerView = nil
+			return
+		}
+
+		guard shimmerView == nil else { return }
+
+		let view = MMMShimmerView()
+		addSubview(view)
+		NSLayoutConstraint.activate(NSLayoutConstraint.constraints(
+			withVisualFormat: "H:|[view]|", metrics: nil, views: [ "view": view ]
+		))
+		NSLayoutConstraint.activate(NSLayoutConstraint.constraints(
+			withVisualFormat: "V:|[view]|", metrics: nil, views: [ "view": view ]
+		))
+		shimmerView = view
+	}
+
+	private func updateLoadedImage(with image: UIImage?, animated: Bool) {
+
+		guard let decoder = decoder, let image = image else {
+			updateImage(with: image, animated: animated)
+			displaysLoadedImage = (image != nil)
+			return
+		}
+
+		if let decoded = decodedImage, decoded.source === image {
+			updateImage(with: decoded.result, animated: animated)
+			displaysLoadedImage = true
+			return
+		}
+
+		// Keeping whatever is displayed now until the decoded version is ready.
+		decodeRequest?.cancel()
+		let scale = window?.screen.scale ?? UIScreen.main.scale
+		decodeRequest = decoder.decodeImage(
+			image,
+			pixelSize: CGSize(width: bounds.width * scale, height: bounds.height * scale),
+			contentMode: mode == .fill ? .fill : .fit
+		) { [weak self] result in
+			guard let self = self else { return }
+			self.decodeRequest = nil
+			self.decodedImage = (source: image, result: result)
+			self.updateImage(with: result, animated: !self.displaysLoadedImage)
+			self.displaysLoadedImage = true
+		}
+	}
+
+	private func cacheKey(for image: MMMLoadableImage) -> MMMDecodedImageCacheKey? {
+		return (image as? MMMDecodedImageCacheSource)?.decodedImageCacheKey
+	}
+
 	private func updateImage(with image: UIImage?, animated: Bool = false) {
 		guard animated else {
 			imageView.image = image
 			return
 		}
+		if let crossfadeCoordinator = crossfadeCoordinator {
+			crossfadeCoordinator.setImage(image, on: imageView)
+			return
+		}
 		UIView.transition(
 			with: imageView,
 			duration: 0.25,
@@ -0,0 +1,269 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+/// Decides which rows of a list should have their content loaded ahead of time and in which order, based on the rows
+/// visible now and the scrolling velocity. Rows are identified by their indexes in the (flattened) list.
+public struct MMMPrefetchPolicy {
+
+	/// How far ahead the rows are prefetched, in seconds of scrolling at the current velocity.
+	public var lookaheadTime: TimeInterval = 1.5
+
+	/// The number of rows on each side of the visible ones that are prefetched even when the list is not scrolling.
+	public var minLookaheadRows: Int = 4
+
+	/// The max number of rows prefetched ahead of the visible ones.
+	public var maxLookaheadRows: Int = 30
+
+	/// The number of rows behind the visible ones that are kept while scrolling, in case the user turns back.
+	public var trailingRows: Int = 2
+
+	/// Velocities below this (in rows per second) mean the list is not scrolling.
+	public var minVelocity: CGFloat = 1
+
+	public init() {}
+
+	/// Priorities of the rows that should be loaded now, by their indexes; the lower the value, the sooner
+	/// the row should be loaded. Ahead of the visible rows the priority is roughly the time in seconds
+	/// till the row becomes visible.
+	///
+	/// - Parameter velocity: Rows per second, positive when scrolling towards the rows with larger indexes.
+	public func priorities(visibleRange: Range<Int>, velocity: CGFloat, numberOfRows: Int) -> [Int: Double] {
+
+		var result = [Int: Double]()
+		let rows = 0..<numberOfRows
+
+		func add(_ index: Int, _ priority: Double) {
+			if rows.contains(index) {
+				result[index] = priority
+			}
+		}
+
+		// Visible rows first, in the order of their appearance.
+		for index in visibleRange {
+			add(index, Double(index - visibleRange.lowerBound) * 0.001)
+		}
+
+		let speed = abs(velocity)
+		if speed < minVelocity {
+			// Not scrolling: the closest rows on both sides.
+			for d in stride(from: 1, through: minLookaheadRows, by: 1) {
+				add(visibleRange.upperBound - 1 + d, Double(d))
+				add(visibleRange.lowerBound - d, Double(d))
+			}
+			return result
+		}
+
+		let ahead = min(maxLookaheadRows, max(minLookaheadRows, Int((Double(speed) * lookaheadTime).rounded(.up))))
+		let forward = velocity > 0
+		for d in stride(from: 1, through: ahead, by: 1) {
+			add(forward ? visibleRange.upperBound - 1 + d : visibleRange.lowerBound - d, Double(CGFloat(d) / speed))
+		}
+
+		// Rows behind only after everything ahead.
+		for d in stride(from: 1, through: trailingRows, by: 1) {
+			add(forward ? visibleRange.lowerBound - d : visibleRange.upperBound - 1 + d, lookaheadTime + Double(d))
+		}
+
+		return result
+	}
+}
+
+/// A binary min-heap.
+internal struct MMMPriorityQueue<Element> {
+
+	private var items: [(priority: Double, element: Element)] = []
+
+	var isEmpty: Bool { items.isEmpty }
+
+	var count: Int { items.count }
+
+	mutating func push(_ element: Element, priority: Double) {
+		items.append((priority, element))
+		var i = items.count - 1
+		while i > 0 {
+			let parent = (i - 1) / 2
+			guard items[i].priority < items[parent].priority else { break }
+			items.swapAt(i, parent)
+			i = parent
+		}
+	}
+
+	mutating func pop() -> Element? {
+
+		guard !items.isEmpty else { return nil }
+
+		items.swapAt(0, items.count - 1)
+		let result = items.removeLast().element
+
+		var i = 0
+		while true {
+			let left = 2 * i + 1
+			let right = left + 1
+			var smallest = i
+			if left < items.count && items[left].priority < items[smallest].priority {
+				smallest = left
+			}
+			if right < items.count && items[right].priority < items[smallest].priority {
+				smallest = right
+			}
+			guard smallest != i else { break }
+			items.swapAt(i, smallest)
+			i = smallest
+		}
+
+		return result
+	}
+}
+
+/// Syncs loadable images of the rows that are about to appear in a list (`MMMTableView`, `MMMCollectionView`, etc),
+/// so they are ready by the time the cells are configured, instead of starting to load only then.
+///
+/// Rows to prefetch and their order are decided by the `policy` from the visible rows and the scrolling velocity.
+/// No more than `maxConcurrentLoads` loadables are syncing because of the coordinator at the same time.
+/// The rows that were scrolled past are not held anymore, so the corresponding loadables can be released
+/// (which cancels their requests where supported, e.g. in `MMMPhotoLibraryLoadableImage`). While such a loadable
+/// is still alive and syncing, it keeps occupying its slot; the slot is reused on one of the next updates
+/// after it finishes or goes away.
+///
+/// Typical usage in the delegate of a table view:
+///
+/// 	func scrollViewDidScroll(_ scrollView: UIScrollView) {
+/// 		let visible = tableView.indexPathsForVisibleRows?.map { $0.row } ?? []
+/// 		prefetcher.scrollViewDidScroll(
+/// 			scrollView,
+/// 			visibleRange: (visible.min() ?? 0)..<((visible.max() ?? -1) + 1),
+/// 			numberOfRows: items.count
+/// 		)
+/// 	}
+public final class MMMPrefetchCoordinator {
+
+	/// The loadable image for the row with the given index, if any.
+	public typealias Provider = (_ index: Int) -> MMMLoadableImage?
+
+	public var policy: MMMPrefetchPolicy
+
+	public let maxConcurrentLoads: Int
+
+	private let provider: Provider
+
+	private let velocityMeter = MMMVelocityMeter()
+
+	private var queue = MMMPriorityQueue<Int>()
+
+	private var loading: [Int: (image: MMMLoadableImage, observer: MMMLoadableObserver?)] = [:]
+
+	private final class WeakImage {
+		weak var image: MMMLoadableImage?
+		init(_ image: MMMLoadableImage) { self.image = image }
+	}
+
+	/// The loads started by us for the rows that were scrolled past. Not holding them, but still counting them
+	/// against `maxConcurrentLoads` until they finish.
+	private var droppedLoads: [WeakImage] = []
+
+	/// The rows whose loadables failed to sync while loaded by us; not retried until they are scrolled past
+	/// or the coordinator is reset, so a failing image is not hammered on every scroll callback.
+	private var failedRows = Set<Int>()
+
+	/// The number of loadables synced by the coordinator. For diagnostics only.
+	public private(set) var numberOfStartedLoads: Int = 0
+
+	/// The number of loads that were not tracked anymore because the rows were scrolled past. For diagnostics only.
+	public private(set) var numberOfDroppedLoads: Int = 0
+
+	/// The number of rows waiting for their turn.
+	public var numberOfPendingLoads: Int { queue.count }
+
+	public init(maxConcurrentLoads: Int = 4, policy: MMMPrefetchPolicy = .init(), provider: @escaping Provider) {
+		self.maxConcurrentLoads = max(1, maxConcurrentLoads)
+		self.policy = policy
+		self.provider = provider
+		velocityMeter.reset()
+	}
+
+	/// Updates the prefetch queue for a vertically scrolling list, estimating the velocity in rows per second
+	/// from the content offset and the average height of the visible rows.
+	public func scrollViewDidScroll(_ scrollView: UIScrollView, visibleRange: Range<Int>, numberOfRows: Int) {
+
+		velocityMeter.addValue(scrollView.contentOffset.y)
+		var velocity: CGFloat = 0
+		velocityMeter.calculateVelocity(&velocity, acceleration: nil)
+
+		let rowHeight = scrollView.bounds.height / CGFloat(max(1, visibleRange.count))
+		update(
+			visibleRange: visibleRange,
+			velocity: rowHeight > 0 ? velocity / rowHeight : 0,
+			numberOfRows: numberOfRows
+		)
+	}
+
+	/// Updates the prefetch queue for the given visible rows and the velocity in rows per second.
+	public func update(visibleRange: Range<Int>, velocity: CGFloat, numberOfRows: Int) {
+
+		let priorities = policy.priorities(visibleRange: visibleRange, velocity: velocity, numberOfRows: numberOfRows)
+
+		// Scrolled past.
+		for (index, entry) in loading where priorities[index] == nil {
+			drop(entry.image)
+			loading[index] = nil
+			numberOfDroppedLoads += 1
+		}
+		failedRows = failedRows.filter { priorities[$0] != nil }
+
+		queue = MMMPriorityQueue()
+		for (index, priority) in priorities where loading[index] == nil && !failedRows.contains(index) {
+			queue.push(index, priority: priority)
+		}
+
+		startLoads()
+	}
+
+	/// Forgets everything, e.g. when the contents of the list changes.
+	public func reset() {
+		queue = MMMPriorityQueue()
+		loading.values.forEach { drop($0.image) }
+		loading.removeAll()
+		failedRows.removeAll()
+		velocityMeter.reset()
+	}
+
+	private func drop(_ image: MMMLoadableImage) {
+		if image.loadableState == .syncing {
+			droppedLoads.append(WeakImage(image))
+		}
+	}
+
+	private func startLoads() {
+
+		droppedLoads.removeAll { $0.image?.loadableState != .syncing }
+
+		while loading.count + droppedLoads.count < maxConcurrentLoads, let index = queue.pop() {
+
+			guard let image = provider(index),
+				!image.isContentsAvailable,
+				image.loadableState != .syncing
+			else {
+				// Nothing to load or somebody is loading it already.
+				continue
+			}
+
+			let observer = MMMLoadableObserver(loadable: image) { [weak self] _ in
+				self?.loadableDidChange(at: index)
+			}
+			loading[index] = (image: image, observer: observer)
+			numberOfStartedLoads += 1
+			image.syncIfNeeded()
+		}
+	}
+
+	private func loadableDidChange(at index: Int) {
+		guard let entry = loading[index], entry.image.loadableState != .syncing else { return }
+		loading[index] = nil
+		if entry.image.loadableState == .didFailToSync {
+			failedRows.insert(index)
+		}
+		startLoads()
+	}
+}
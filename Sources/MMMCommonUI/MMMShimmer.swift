@@ -0,0 +1,179 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+/// Where the highlight band of the shimmer effect is at the given moment. All the calculations are in window
+/// coordinates, so placeholders in different places of the screen show parts of the same band and line up.
+public struct MMMShimmerGeometry {
+
+	/// The time it takes for the band to cross the window.
+	public var period: TimeInterval = 1.4
+
+	/// The width of the highlight band.
+	public var bandWidth: CGFloat = 160
+
+	/// How much the band is shifted horizontally per point of vertical position; makes it go diagonally.
+	public var slope: CGFloat = 0.25
+
+	public init() {}
+
+	/// The phase of the shimmer clock, within [0; 1), at the given moment.
+	public func phase(at time: TimeInterval) -> CGFloat {
+		let t = time / period
+		return CGFloat(t - t.rounded(.down))
+	}
+
+	/// The horizontal position of the center of the band at the given phase for a point with the given vertical
+	/// position within a window of the given size. The band starts fully outside of the left edge of the window
+	/// and ends fully outside of the right one.
+	public func bandCenter(phase: CGFloat, windowSize: CGSize, y: CGFloat) -> CGFloat {
+		let extra = bandWidth + 2 * abs(slope) * windowSize.height
+		return -extra / 2 + phase * (windowSize.width + extra) - y * slope
+	}
+}
+
+/// Drives all the visible `MMMShimmerView`s from a single `MMMAnimator` item, so a screen full of placeholders
+/// costs a single update per frame instead of an animation per view. Stops when none of the views is in a window.
+public final class MMMShimmerDriver {
+
+	/// The instance used by `MMMShimmerView` by default.
+	public static let shared = MMMShimmerDriver()
+
+	public var geometry = MMMShimmerGeometry()
+
+	private let animator: MMMAnimator
+
+	private let views = NSHashTable<MMMShimmerView>.weakObjects()
+
+	private var animation: MMMAnimationHandle?
+
+	/// The number of frames the views were updated in. For diagnostics only.
+	public private(set) var numberOfUpdates: Int = 0
+
+	/// True, if the animator item is running.
+	public var isRunning: Bool { animation != nil }
+
+	public init(animator: MMMAnimator = .shared()) {
+		self.animator = animator
+	}
+
+	internal func visibilityDidChange(for view: MMMShimmerView) {
+		if view.window != nil && view.isShimmering {
+			views.add(view)
+			startIfNeeded()
+			// Not waiting for the next frame, so the view does not flash without the band.
+			if let phase = lastPhase {
+				update(view, phase: phase)
+			}
+		} else {
+			views.remove(view)
+		}
+	}
+
+	private var lastPhase: CGFloat?
+
+	private func startIfNeeded() {
+
+		guard animation == nil else { return }
+
+		// Our own clock instead of the time of the item, so the phase is continuous when the item is restarted.
+		let start = CACurrentMediaTime()
+		animation = animator.addAnimation(
+			duration: CGFloat(geometry.period),
+			repeatCount: 0,
+			autoreverse: false,
+			update: { [weak self] _, _ in
+				guard let self = self else { return }
+				self.tick(phase: self.geometry.phase(at: CACurrentMediaTime() - start))
+			},
+			completion: nil
+		)
+	}
+
+	private func tick(phase: CGFloat) {
+
+		lastPhase = phase
+
+		var visible = 0
+		CATransaction.begin()
+		CATransaction.setDisableActions(true)
+		for view in views.allObjects where view.window != nil && view.isShimmering {
+			update(view, phase: phase)
+			visible += 1
+		}
+		CATransaction.commit()
+
+		if visible > 0 {
+			numberOfUpdates += 1
+		} else {
+			// Nobody to animate; the next view appearing in a window restarts it.
+			animation?.cancel()
+			animation = nil
+			lastPhase = nil
+		}
+	}
+
+	private func update(_ view: MMMShimmerView, phase: CGFloat) {
+		guard let window = view.window else { return }
+		let origin = view.convert(CGPoint.zero, to: nil)
+		// Where the band crosses the top edge of the view; the rest follows the slope, so the neighbouring views
+		// show parts of the same diagonal band regardless of their height.
+		let center = geometry.bandCenter(phase: phase, windowSize: window.bounds.size, y: origin.y)
+		view.setBand(center: center - origin.x, width: geometry.bandWidth, slope: geometry.slope)
+	}
+}
+
+/// A placeholder with a highlight band moving across it (a "shimmer"), which is driven by `MMMShimmerDriver`
+/// together with the rest of the placeholders.
+public final class MMMShimmerView: NonStoryboardableView {
+
+	private let driver: MMMShimmerDriver
+	private let bandLayer = CAGradientLayer()
+
+	/// Set to false to show only the background color.
+	public var isShimmering: Bool = true {
+		didSet {
+			bandLayer.isHidden = !isShimmering
+			driver.visibilityDidChange(for: self)
+		}
+	}
+
+	public init(
+		color: UIColor = UIColor(white: 0.9, alpha: 1),
+		highlightColor: UIColor = UIColor(white: 0.96, alpha: 1),
+		driver: MMMShimmerDriver = .shared
+	) {
+
+		self.driver = driver
+
+		super.init()
+
+		self.backgroundColor = color
+		self.clipsToBounds = true
+		self.isUserInteractionEnabled = false
+
+		let clear = highlightColor.withAlphaComponent(0)
+		bandLayer.colors = [clear.cgColor, highlightColor.cgColor, clear.cgColor]
+		layer.addSublayer(bandLayer)
+	}
+
+	public override func didMoveToWindow() {
+		super.didMoveToWindow()
+		driver.visibilityDidChange(for: self)
+	}
+
+	/// Places the band so it crosses the top edge at `center` and is sheared by `slope` (going left by `slope` points
+	/// per point down) with `width` measured horizontally.
+	internal func setBand(center: CGFloat, width: CGFloat, slope: CGFloat) {
+
+		bandLayer.frame = bounds
+		guard bounds.width > 0, bounds.height > 0 else { return }
+
+		// The gradient goes perpendicular to the lines of the band, i.e. along (1, slope), and spans `width`
+		// horizontally, which is `width / sqrt(1 + slope^2)` along that direction.
+		let k = width / 2 / (1 + slope * slope)
+		bandLayer.startPoint = CGPoint(x: (center - k) / bounds.width, y: -k * slope / bounds.height)
+		bandLayer.endPoint = CGPoint(x: (center + k) / bounds.width, y: k * slope / bounds.height)
+	}
+}
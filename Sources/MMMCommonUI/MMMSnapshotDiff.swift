@@ -0,0 +1,493 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+/// Diff algorithms used by `MMMSnapshot`. They don't depend on UIKit.
+public enum MMMDiff {
+
+	/// Matches the elements of two arrays of unique identifiers following Heckel's algorithm
+	/// ("A technique for isolating differences between files", 1978) in O(n).
+	///
+	/// Returns the index of the matching new element for every old one (or `nil` if it was deleted),
+	/// or `nil` when any of the arrays has duplicates. (With unique identifiers every element is a "unique line"
+	/// in Heckel's terms, so the passes propagating matches to non-unique neighbours are not needed.)
+	public static func heckel<T: Hashable>(_ old: [T], _ new: [T]) -> [Int?]? {
+
+		// Pass 1: the symbol table for the new elements.
+		var newIndex = [T: Int](minimumCapacity: new.count)
+		for (i, id) in new.enumerated() {
+			if newIndex.updateValue(i, forKey: id) != nil {
+				return nil
+			}
+		}
+
+		// Passes 2-3: old elements matched via the table.
+		var seen = Set<T>(minimumCapacity: old.count)
+		var oldToNew = [Int?](repeating: nil, count: old.count)
+		for (i, id) in old.enumerated() {
+			if !seen.insert(id).inserted {
+				return nil
+			}
+			oldToNew[i] = newIndex[id]
+		}
+
+		return oldToNew
+	}
+
+	/// The shortest edit script between two arrays (Myers, "An O(ND) difference algorithm and its variations", 1986)
+	/// as indexes of the deleted old elements and the inserted new ones, both sorted. Works with duplicates,
+	/// but does not detect moves. The time is O((N + M) * D), where D is the number of edits; the memory is O(N + M)
+	/// as the linear space variation from the same paper is used, splitting the problem at its "middle snake".
+	public static func myers<T: Equatable>(_ old: [T], _ new: [T]) -> (deleted: [Int], inserted: [Int]) {
+		var deleted: [Int] = []
+		var inserted: [Int] = []
+		myers(old, 0..<old.count, new, 0..<new.count, deleted: &deleted, inserted: &inserted)
+		return (deleted, inserted)
+	}
+
+	private static func myers<T: Equatable>(
+		_ old: [T], _ oldRange: Range<Int>,
+		_ new: [T], _ newRange: Range<Int>,
+		deleted: inout [Int],
+		inserted: inout [Int]
+	) {
+		var oldLo = oldRange.lowerBound, oldHi = oldRange.upperBound
+		var newLo = newRange.lowerBound, newHi = newRange.upperBound
+
+		// The common prefix and suffix are not edits; trimming them also guarantees that both halves
+		// after the split are smaller than the whole.
+		while oldLo < oldHi && newLo < newHi && old[oldLo] == new[newLo] {
+			oldLo += 1
+			newLo += 1
+		}
+		while oldLo < oldHi && newLo < newHi && old[oldHi - 1] == new[newHi - 1] {
+			oldHi -= 1
+			newHi -= 1
+		}
+
+		guard oldLo < oldHi else {
+			inserted.append(contentsOf: newLo..<newHi)
+			return
+		}
+		guard newLo < newHi else {
+			deleted.append(contentsOf: oldLo..<oldHi)
+			return
+		}
+
+		if let split = middleSnake(old, oldLo..<oldHi, new, newLo..<newHi) {
+			// Lower indexes first, so the results stay sorted.
+			myers(old, oldLo..<split.x, new, newLo..<split.y, deleted: &deleted, inserted: &inserted)
+			myers(old, split.x..<oldHi, new, split.y..<newHi, deleted: &deleted, inserted: &inserted)
+		} else {
+			deleted.append(contentsOf: oldLo..<oldHi)
+			inserted.append(contentsOf: newLo..<newHi)
+		}
+	}
+
+	/// The point where the paths searched forward from the beginning and backward from the end meet,
+	/// so the parts before and after it can be diffed separately. Returns `nil` when nothing is in common.
+	private static func middleSnake<T: Equatable>(
+		_ old: [T], _ oldRange: Range<Int>,
+		_ new: [T], _ newRange: Range<Int>
+	) -> (x: Int, y: Int)? {
+
+		let n = oldRange.count, m = newRange.count
+		let oldLo = oldRange.lowerBound, newLo = newRange.lowerBound
+
+		let maxD = (n + m + 1) / 2
+		let offset = maxD
+		// The furthest reaching x for every diagonal k = x - y of the forward paths, and the same for the backward
+		// ones in the coordinates going from the end; -1 for diagonals not reached yet.
+		var forward = [Int](repeating: -1, count: 2 * maxD + 2)
+		var backward = forward
+		forward[offset + 1] = 0
+		backward[offset + 1] = 0
+
+		let delta = n - m
+		// The paths can meet only after a forward step when the difference is odd, and after a backward one otherwise.
+		let meetsForward = delta % 2 != 0
+		// Diagonals that went outside of the edit graph are not extended anymore.
+		var forwardStart = 0, forwardEnd = 0, backwardStart = 0, backwardEnd = 0
+
+		for d in 0..<maxD {
+
+			for k in stride(from: -d + forwardStart, through: d - forwardEnd, by: 2) {
+				var x: Int
+				if k == -d || (k != d && forward[offset + k - 1] < forward[offset + k + 1]) {
+					x = forward[offset + k + 1]
+				} else {
+					x = forward[offset + k - 1] + 1
+				}
+				var y = x - k
+				while x < n && y < m && old[oldLo + x] == new[newLo + y] {
+					x += 1
+					y += 1
+				}
+				forward[offset + k] = x
+
+				if x > n {
+					forwardEnd += 2
+				} else if y > m {
+					forwardStart += 2
+				} else if meetsForward {
+					let i = offset + delta - k
+					if i >= 0 && i < backward.count && backward[i] != -1 && x >= n - backward[i] {
+						return (x: oldLo + x, y: newLo + y)
+					}
+				}
+			}
+
+			for k in stride(from: -d + backwardStart, through: d - backwardEnd, by: 2) {
+				var x: Int
+				if k == -d || (k != d && backward[offset + k - 1] < backward[offset + k + 1]) {
+					x = backward[offset + k + 1]
+				} else {
+					x = backward[offset + k - 1] + 1
+				}
+				var y = x - k
+				while x < n && y < m && old[oldLo + n - 1 - x] == new[newLo + m - 1 - y] {
+					x += 1
+					y += 1
+				}
+				backward[offset + k] = x
+
+				if x > n {
+					backwardEnd += 2
+				} else if y > m {
+					backwardStart += 2
+				} else if !meetsForward {
+					let i = offset + delta - k
+					if i >= 0 && i < forward.count && forward[i] != -1 && forward[i] >= n - x {
+						let forwardX = forward[i]
+						return (x: oldLo + forwardX, y: newLo + forwardX - (i - offset))
+					}
+				}
+			}
+		}
+
+		return nil
+	}
+
+	/// Positions (in the given sequence) of the elements forming one of its longest increasing subsequences.
+	/// Elements matched between two arrays that are not part of it are the ones that should be moved.
+	public static func longestIncreasingSubsequence(_ values: [Int]) -> Set<Int> {
+
+		// Patience sorting: the positions of the smallest tails of increasing subsequences of every length.
+		var tails: [Int] = []
+		var previous = [Int](repeating: -1, count: values.count)
+
+		for (i, value) in values.enumerated() {
+			var lo = 0, hi = tails.count
+			while lo < hi {
+				let mid = (lo + hi) / 2
+				if values[tails[mid]] < value {
+					lo = mid + 1
+				} else {
+					hi = mid
+				}
+			}
+			if lo > 0 {
+				previous[i] = tails[lo - 1]
+			}
+			if lo == tails.count {
+				tails.append(i)
+			} else {
+				tails[lo] = i
+			}
+		}
+
+		var result = Set<Int>(minimumCapacity: tails.count)
+		var i = tails.last ?? -1
+		while i >= 0 {
+			result.insert(i)
+			i = previous[i]
+		}
+		return result
+	}
+}
+
+/// Identifiers of the sections and items of a table or collection view, so the changes between two states
+/// can be applied as a single batch update instead of `reloadData`.
+public struct MMMSnapshot<SectionID: Hashable, ItemID: Hashable> {
+
+	public private(set) var sectionIdentifiers: [SectionID] = []
+	public private(set) var itemIdentifiers: [[ItemID]] = []
+
+	public init() {}
+
+	public mutating func appendSection(_ identifier: SectionID, items: [ItemID]) {
+		sectionIdentifiers.append(identifier)
+		itemIdentifiers.append(items)
+	}
+
+	/// The changes turning the receiver into the given snapshot.
+	///
+	/// Items are matched in O(n) via Heckel's algorithm when their identifiers are unique across all the sections,
+	/// otherwise the items of every section are compared with Myers' algorithm, so there are no moves then.
+	///
+	/// - Parameter reloaded: Identifiers of items that are present in both snapshots but have their content changed.
+	///
+	/// - Returns: `nil` if section identifiers are not unique and thus all the data has to be reloaded.
+	public func changes(to new: MMMSnapshot, reloaded: Set<ItemID> = []) -> MMMSnapshotChanges? {
+
+		guard let sectionOldToNew = MMMDiff.heckel(sectionIdentifiers, new.sectionIdentifiers) else {
+			return nil
+		}
+
+		var changes = MMMSnapshotChanges()
+
+		// Sections.
+		var sectionNewToOld = [Int?](repeating: nil, count: new.sectionIdentifiers.count)
+		for (oldSection, newSection) in sectionOldToNew.enumerated() {
+			if let newSection = newSection {
+				sectionNewToOld[newSection] = oldSection
+			} else {
+				changes.deletedSections.insert(oldSection)
+			}
+		}
+		var matchedOldSections: [Int] = []
+		for (newSection, oldSection) in sectionNewToOld.enumerated() {
+			if let oldSection = oldSection {
+				matchedOldSections.append(oldSection)
+			} else {
+				changes.insertedSections.insert(newSection)
+			}
+		}
+		let stableSections = MMMDiff.longestIncreasingSubsequence(matchedOldSections)
+		for (i, oldSection) in matchedOldSections.enumerated() where !stableSections.contains(i) {
+			changes.movedSections.append((from: oldSection, to: sectionOldToNew[oldSection]!))
+		}
+
+		// Items.
+		let oldItems = itemIdentifiers.joined()
+		let newItems = new.itemIdentifiers.joined()
+		if let itemOldToNew = MMMDiff.heckel(Array(oldItems), Array(newItems)) {
+			diffUniqueItems(to: new, itemOldToNew: itemOldToNew, sectionOldToNew: sectionOldToNew, reloaded: reloaded, changes: &changes)
+		} else {
+			diffItemsPerSection(to: new, sectionOldToNew: sectionOldToNew, reloaded: reloaded, changes: &changes)
+		}
+
+		return changes
+	}
+
+	private static func indexPaths(_ items: [[ItemID]]) -> [IndexPath] {
+		var result: [IndexPath] = []
+		for (section, rows) in items.enumerated() {
+			for row in rows.indices {
+				result.append(IndexPath(row: row, section: section))
+			}
+		}
+		return result
+	}
+
+	private func diffUniqueItems(
+		to new: MMMSnapshot,
+		itemOldToNew: [Int?],
+		sectionOldToNew: [Int?],
+		reloaded: Set<ItemID>,
+		changes: inout MMMSnapshotChanges
+	) {
+		let oldPaths = MMMSnapshot.indexPaths(itemIdentifiers)
+		let newPaths = MMMSnapshot.indexPaths(new.itemIdentifiers)
+		let oldItems = Array(itemIdentifiers.joined())
+
+		var matchedNew = [Bool](repeating: false, count: newPaths.count)
+		// Items staying within the same section: (old row, new path, id) in the order of the new rows.
+		var stayingBySection = [[(oldRow: Int, from: IndexPath, to: IndexPath, id: ItemID)]](
+			repeating: [], count: new.sectionIdentifiers.count
+		)
+
+		for (i, newIndex) in itemOldToNew.enumerated() {
+
+			let from = oldPaths[i]
+			let oldSectionTarget = sectionOldToNew[from.section]
+
+			guard let newIndex = newIndex else {
+				// Deleted, unless it goes away together with its section.
+				if oldSectionTarget != nil {
+					changes.deletedItems.append(from)
+				}
+				continue
+			}
+
+			matchedNew[newIndex] = true
+			let to = newPaths[newIndex]
+			let sectionInserted = changes.insertedSections.contains(to.section)
+
+			switch (oldSectionTarget, sectionInserted) {
+			case (nil, true):
+				// Both sections are handled as a whole.
+				break
+			case (nil, false):
+				changes.insertedItems.append(to)
+			case (_, true):
+				changes.deletedItems.append(from)
+			case (let target?, false):
+				if target == to.section {
+					stayingBySection[to.section].append((oldRow: from.row, from: from, to: to, id: oldItems[i]))
+				} else {
+					changes.move(from: from, to: to, reload: reloaded.contains(oldItems[i]))
+				}
+			}
+		}
+
+		for (newIndex, matched) in matchedNew.enumerated() where !matched {
+			let to = newPaths[newIndex]
+			if !changes.insertedSections.contains(to.section) {
+				changes.insertedItems.append(to)
+			}
+		}
+
+		for staying in stayingBySection where !staying.isEmpty {
+			let sorted = staying.sorted { $0.to.row < $1.to.row }
+			let stable = MMMDiff.longestIncreasingSubsequence(sorted.map { $0.oldRow })
+			for (i, item) in sorted.enumerated() {
+				if stable.contains(i) {
+					if reloaded.contains(item.id) {
+						changes.reloadedItems.append(item.from)
+					}
+				} else {
+					changes.move(from: item.from, to: item.to, reload: reloaded.contains(item.id))
+				}
+			}
+		}
+	}
+
+	private func diffItemsPerSection(
+		to new: MMMSnapshot,
+		sectionOldToNew: [Int?],
+		reloaded: Set<ItemID>,
+		changes: inout MMMSnapshotChanges
+	) {
+		for (oldSection, newSection) in sectionOldToNew.enumerated() {
+
+			guard let newSection = newSection else { continue }
+
+			let old = itemIdentifiers[oldSection]
+			let new = new.itemIdentifiers[newSection]
+			let (deleted, inserted) = MMMDiff.myers(old, new)
+
+			changes.deletedItems.append(contentsOf: deleted.map { IndexPath(row: $0, section: oldSection) })
+			changes.insertedItems.append(contentsOf: inserted.map { IndexPath(row: $0, section: newSection) })
+
+			if !reloaded.isEmpty {
+				let deletedSet = Set(deleted)
+				for (row, id) in old.enumerated() where !deletedSet.contains(row) && reloaded.contains(id) {
+					changes.reloadedItems.append(IndexPath(row: row, section: oldSection))
+				}
+			}
+		}
+	}
+}
+
+/// Changes between two `MMMSnapshot`s in the form expected by batch updates of table and collection views:
+/// deleted, moved (from) and reloaded paths are in terms of the old snapshot; inserted and moved (to) ones
+/// are in terms of the new snapshot.
+public struct MMMSnapshotChanges {
+
+	public var deletedSections = IndexSet()
+	public var insertedSections = IndexSet()
+	public var movedSections: [(from: Int, to: Int)] = []
+
+	public var deletedItems: [IndexPath] = []
+	public var insertedItems: [IndexPath] = []
+	public var movedItems: [(from: IndexPath, to: IndexPath)] = []
+	public var reloadedItems: [IndexPath] = []
+
+	public init() {}
+
+	public var isEmpty: Bool {
+		return deletedSections.isEmpty && insertedSections.isEmpty && movedSections.isEmpty
+			&& deletedItems.isEmpty && insertedItems.isEmpty && movedItems.isEmpty && reloadedItems.isEmpty
+	}
+
+	fileprivate mutating func move(from: IndexPath, to: IndexPath, reload: Bool) {
+		if reload {
+			// A moved item cannot be reloaded in the same batch.
+			deletedItems.append(from)
+			insertedItems.append(to)
+		} else {
+			movedItems.append((from: from, to: to))
+		}
+	}
+}
+
+extension UITableView {
+
+	/// Applies the changes between two snapshots as a single batch update. The data source should switch
+	/// to the new snapshot in `updateData`, which is called within the batch. Falls back to `reloadData()`
+	/// when `changes` is `nil`.
+	public func mmm_performBatchUpdates(
+		_ changes: MMMSnapshotChanges?,
+		animation: UITableView.RowAnimation = .automatic,
+		updateData: () -> Void,
+		completion: ((Bool) -> Void)? = nil
+	) {
+		guard let changes = changes else {
+			updateData()
+			reloadData()
+			completion?(true)
+			return
+		}
+		guard !changes.isEmpty else {
+			updateData()
+			completion?(true)
+			return
+		}
+		// The batch is performed synchronously, so the block does not actually escape.
+		withoutActuallyEscaping(updateData) { updateData in performBatchUpdates({
+			updateData()
+			deleteSections(changes.deletedSections, with: animation)
+			insertSections(changes.insertedSections, with: animation)
+			for move in changes.movedSections {
+				moveSection(move.from, toSection: move.to)
+			}
+			deleteRows(at: changes.deletedItems, with: animation)
+			insertRows(at: changes.insertedItems, with: animation)
+			for move in changes.movedItems {
+				moveRow(at: move.from, to: move.to)
+			}
+			reloadRows(at: changes.reloadedItems, with: animation)
+		}, completion: completion) }
+	}
+}
+
+extension UICollectionView {
+
+	/// Applies the changes between two snapshots as a single batch update. The data source should switch
+	/// to the new snapshot in `updateData`, which is called within the batch. Falls back to `reloadData()`
+	/// when `changes` is `nil`.
+	public func mmm_performBatchUpdates(
+		_ changes: MMMSnapshotChanges?,
+		updateData: () -> Void,
+		completion: ((Bool) -> Void)? = nil
+	) {
+		guard let changes = changes else {
+			updateData()
+			reloadData()
+			completion?(true)
+			return
+		}
+		guard !changes.isEmpty else {
+			updateData()
+			completion?(true)
+			return
+		}
+		// The batch is performed synchronously, so the block does not actually escape.
+		withoutActuallyEscaping(updateData) { updateData in performBatchUpdates({
+			updateData()
+			deleteSections(changes.deletedSections)
+			insertSections(changes.insertedSections)
+			for move in changes.movedSections {
+				moveSection(move.from, toSection: move.to)
+			}
+			deleteItems(at: changes.deletedItems)
+			insertItems(at: changes.insertedItems)
+			for move in changes.movedItems {
+				moveItem(at: move.from, to: move.to)
+			}
+			reloadItems(at: changes.reloadedItems)
+		}, completion: completion) }
+	}
+}
@@ -22,8 +22,8 @@ NS_ASSUME_NONNULL_BEGIN
 /** Adds a coordinate with the current timstamp. */
 - (void)addValue:(CGFloat)value;
 
-/** Calculates velocity and acceleration based on recently added values. */
-- (void)calculateVelocity:(CGFloat *)velocity acceleration:(CGFloat *)acceleration;
+/** Calculates velocity and acceleration based on recently added values. Either of the outputs can be NULL. */
+- (void)calculateVelocity:(CGFloat * _Nullable)velocity acceleration:(CGFloat * _Nullable)acceleration;
 
 @end
 
@@ -63,6 +63,15 @@ typedef NS_ENUM(NSInteger, MMMAnimationCurve) {
 /** Animation curve opposite to the given one, e.g. EaseIn for EaseOut. */
 extern MMMAnimationCurve MMMReverseAnimationCurve(MMMAnimationCurve curve);
 
+/**
+ * One of our curves closest to the given UIKit curve, so animations driven by MMMAnimator can follow
+ * the ones performed by the system, e.g. the keyboard appearance.
+ *
+ * Note that undocumented values (such as 7 used by the keyboard) are mapped into a steep "ease out" curve,
+ * which is only an approximation of the spring-like curve used by the system.
+ */
+extern MMMAnimationCurve MMMAnimationCurveFromViewAnimationCurve(UIViewAnimationCurve curve);
+
 /** 
  * Minimalistic animation helpers.
  *
@@ -113,6 +122,12 @@ extern MMMAnimationCurve MMMReverseAnimationCurve(MMMAnimationCurve curve);
  */
 + (CGPoint)pointFrom:(CGPoint)from to:(CGPoint)to time:(CGFloat)time;
 
+/**
+ * A rect with the origin and the size interpolated between the ones of the given rects
+ * corresponding to already normalized and curved time.
+ */
++ (CGRect)rectFrom:(CGRect)from to:(CGRect)to time:(CGFloat)time;
+
 @end
 
 @class MMMAnimationHandle;
@@ -150,6 +150,23 @@ MMMAnimationCurve MMMReverseAnimationCurve(MMMAnimationCurve curve) {
 	}
 }
 
+MMMAnimationCurve MMMAnimationCurveFromViewAnimationCurve(UIViewAnimationCurve curve) {
+
+	switch (curve) {
+		case UIViewAnimationCurveLinear:
+			return MMMAnimationCurveLinear;
+		case UIViewAnimationCurveEaseIn:
+			return MMMAnimationCurveEaseIn;
+		case UIViewAnimationCurveEaseOut:
+			return MMMAnimationCurveEaseOut;
+		case UIViewAnimationCurveEaseInOut:
+			return MMMAnimationCurveEaseInOut;
+	}
+
+	// Private curves, like the one used with the keyboard, are spring-like: fast start and a long tail.
+	return MMMAnimationCurveEaseOutQuart;
+}
+
 //
 //
 //
@@ -363,6 +380,15 @@ static inline CGFloat MMMAnimationUtils_BaseCurve(CGFloat time, MMMAnimationCurv
 	);
 }
 
++ (CGRect)rectFrom:(CGRect)from to:(CGRect)to time:(CGFloat)time {
+	return CGRectMake(
+		[self interpolateFrom:from.origin.x to:to.origin.x time:time],
+		[self interpolateFrom:from.origin.y to:to.origin.y time:time],
+		[self interpolateFrom:from.size.width to:to.size.width time:time],
+		[self interpolateFrom:from.size.height to:to.size.height time:time]
+	);
+}
+
 @end
 
 //
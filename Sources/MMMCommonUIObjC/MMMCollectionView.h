@@ -14,7 +14,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface MMMCollectionView : UICollectionView
 
-/** Uses UICollectionViewFlowLayout by default. */
+/** Allows to use a custom layout, e.g. `MMMCollectionViewLayout` for large data sets. */
+- (instancetype)initWithSettings:(MMMScrollViewShadowsSettings *)settings
+	collectionViewLayout:(UICollectionViewLayout *)layout NS_DESIGNATED_INITIALIZER;
+
+/** Uses UICollectionViewFlowLayout. */
 - (instancetype)initWithSettings:(MMMScrollViewShadowsSettings *)settings NS_DESIGNATED_INITIALIZER;
 
 - (instancetype)initWithFrame:(CGRect)frame collectionViewLayout:(UICollectionViewLayout *)layout NS_UNAVAILABLE;
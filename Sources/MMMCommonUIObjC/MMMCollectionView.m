@@ -11,16 +11,30 @@
 
 - (instancetype)initWithSettings:(MMMScrollViewShadowsSettings *)settings {
 
+	// Both initializers are designated, so subclasses overriding the original one keep working.
 	if (self = [super initWithFrame:CGRectMake(0, 0, 320, 400) collectionViewLayout:[[UICollectionViewFlowLayout alloc] init]]) {
+		[self setUpWithSettings:settings];
+	}
+
+	return self;
+}
 
-		self.translatesAutoresizingMaskIntoConstraints = NO;
+- (instancetype)initWithSettings:(MMMScrollViewShadowsSettings *)settings collectionViewLayout:(UICollectionViewLayout *)layout {
 
-		_shadows = [[MMMScrollViewShadows alloc] initWithScrollView:self settings:settings];
+	if (self = [super initWithFrame:CGRectMake(0, 0, 320, 400) collectionViewLayout:layout]) {
+		[self setUpWithSettings:settings];
 	}
 
 	return self;
 }
 
+- (void)setUpWithSettings:(MMMScrollViewShadowsSettings *)settings {
+
+	self.translatesAutoresizingMaskIntoConstraints = NO;
+
+	_shadows = [[MMMScrollViewShadows alloc] initWithScrollView:self settings:settings];
+}
+
 - (void)layoutSubviews {
 	[super layoutSubviews];
 	[_shadows layoutSubviews];
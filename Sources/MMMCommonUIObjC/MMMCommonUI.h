@@ -7,6 +7,10 @@
 #import "MMMAutoLayoutScrollView.h"
 #import "MMMCollectionView.h"
 #import "MMMCommonUIMisc.h"
+#import "MMMDecodedImageCache.h"
+#import "MMMGradientRasterizer.h"
+#import "MMMImageDecoder.h"
+#import "MMMImageRequestCoalescer.h"
 #import "MMMImageView.h"
 #import "MMMKeyboard.h"
 #import "MMMLayout.h"
@@ -14,7 +18,9 @@
 #import "MMMNavigationStack.h"
 #import "MMMPhoto.h"
 #import "MMMPhotoLibraryLoadableImage.h"
+#import "MMMPlaceholderImage.h"
 #import "MMMPreferredSizeChanges.h"
+#import "MMMRowHeightCache.h"
 #import "MMMScrollViewShadows.h"
 #import "MMMShadowView.h"
 #import "MMMStubView.h"
@@ -23,5 +29,6 @@
 #import "MMMTableView.h"
 #import "MMMTableViewCell.h"
 #import "MMMVerticalGradientView.h"
+#import "MMMViewReusePool.h"
 #import "MMMViewWrappingCell.h"
 #import "MMMWebView.h"
@@ -0,0 +1,108 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+@import UIKit;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Identifies a decoded image: where it comes from (a URL, an asset identifier, etc), its size in pixels
+ * and how it was fit into that size (e.g. a raw value of `PHImageContentMode`).
+ */
+@interface MMMDecodedImageCacheKey : NSObject <NSCopying>
+
+@property (nonatomic, readonly) NSString *sourceIdentifier;
+@property (nonatomic, readonly) CGSize pixelSize;
+@property (nonatomic, readonly) NSInteger contentMode;
+
+/** The pixel size is rounded to whole pixels, so keys calculated from points are still stable. */
+- (id)initWithSourceIdentifier:(NSString *)sourceIdentifier
+	pixelSize:(CGSize)pixelSize
+	contentMode:(NSInteger)contentMode NS_DESIGNATED_INITIALIZER;
+
+- (id)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ * A loadable image (or anything else) that can tell under which key its contents would be stored
+ * in `MMMDecodedImageCache`, so it's possible to reuse a decoded image produced by another instance
+ * pointing to the same source.
+ *
+ * Loadables adopting this own the cache entries: they should look into the shared cache in `doSync`
+ * and store their final results there themselves. Others (like `MMMLoadableImageView`) only read the cache.
+ */
+@protocol MMMDecodedImageCacheSource <NSObject>
+
+@property (nonatomic, readonly, nullable) MMMDecodedImageCacheKey *decodedImageCacheKey;
+
+@end
+
+/**
+ * A process-wide memory cache of decoded images, so views showing the same URL or asset at the same size
+ * share a single bitmap instead of keeping and decoding their own copies.
+ *
+ * Unlike `NSCache` the eviction is predictable: the cost of every image is the actual size of its bitmap
+ * and the least recently used images are dropped first once the total cost goes over the limit.
+ *
+ * Thread-safe, so images can be stored right where they are decoded.
+ */
+@interface MMMDecodedImageCache : NSObject
+
+/** The instance used by the loadable images and image views of this library. */
++ (instancetype)shared;
+
+/** A cache that keeps up to `totalCostLimit` bytes of bitmaps. */
+- (id)initWithTotalCostLimit:(NSUInteger)totalCostLimit NS_DESIGNATED_INITIALIZER;
+
+/** A cache with a limit based on the physical memory of the device. */
+- (id)init;
+
+/** The max total size of bitmaps in bytes. Lowering it evicts images right away. */
+@property (atomic) NSUInteger totalCostLimit;
+
+/** The image stored under the given key or nil. Marks the image as the most recently used one. */
+- (nullable UIImage *)imageForKey:(MMMDecodedImageCacheKey *)key;
+
+/** Stores an image under the given key replacing the previous one. Images larger than the limit are not stored. */
+- (void)setImage:(UIImage *)image forKey:(MMMDecodedImageCacheKey *)key;
+
+- (void)removeImageForKey:(MMMDecodedImageCacheKey *)key;
+
+- (void)removeAllImages;
+
+/**
+ * Evicts the least recently used images until the total cost is at most the given number of bytes.
+ * The limit itself is not changed.
+ */
+- (void)trimToCost:(NSUInteger)cost;
+
+/**
+ * Called on memory warnings (and can be called from other places having hints about memory pressure):
+ * evicts everything when `critical` or half of the limit worth of the images otherwise.
+ */
+- (void)handleMemoryPressureCritical:(BOOL)critical;
+
+/** The cost the cache would account for the given image: the size of its bitmap(s) in bytes. */
++ (NSUInteger)costForImage:(UIImage *)image;
+
+/** The number of images stored currently. */
+@property (nonatomic, readonly) NSInteger count;
+
+/** The total size of the stored bitmaps in bytes. */
+@property (nonatomic, readonly) NSUInteger totalCost;
+
+/** The number of lookups that have found an image. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfHits;
+
+/** The number of lookups that have not found an image. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfMisses;
+
+/** The number of images dropped because of the limit or memory pressure. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfEvictions;
+
+@end
+
+NS_ASSUME_NONNULL_END
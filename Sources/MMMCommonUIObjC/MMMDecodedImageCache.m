@@ -0,0 +1,308 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+#import "MMMDecodedImageCache.h"
+
+#import <os/lock.h>
+
+@implementation MMMDecodedImageCacheKey {
+	NSUInteger _hash;
+}
+
+- (id)initWithSourceIdentifier:(NSString *)sourceIdentifier pixelSize:(CGSize)pixelSize contentMode:(NSInteger)contentMode {
+
+	if (self = [super init]) {
+		_sourceIdentifier = [sourceIdentifier copy];
+		_pixelSize = CGSizeMake(round(pixelSize.width), round(pixelSize.height));
+		_contentMode = contentMode;
+		_hash = _sourceIdentifier.hash
+			^ ((NSUInteger)_pixelSize.width * 31 + (NSUInteger)_pixelSize.height) * 0x9E3779B1
+			^ (NSUInteger)_contentMode;
+	}
+
+	return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+	// Immutable.
+	return self;
+}
+
+- (NSUInteger)hash {
+	return _hash;
+}
+
+- (BOOL)isEqual:(id)object {
+	if (self == object)
+		return YES;
+	if (![object isKindOfClass:[MMMDecodedImageCacheKey class]])
+		return NO;
+	MMMDecodedImageCacheKey *other = object;
+	return _hash == other->_hash
+		&& _contentMode == other->_contentMode
+		&& CGSizeEqualToSize(_pixelSize, other->_pixelSize)
+		&& [_sourceIdentifier isEqualToString:other->_sourceIdentifier];
+}
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %@ %.0fx%.0f mode %ld>",
+		self.class, _sourceIdentifier, _pixelSize.width, _pixelSize.height, (long)_contentMode
+	];
+}
+
+@end
+
+/// A node of the LRU list. The dictionary owns the nodes, so the links are not retaining.
+@interface MMMDecodedImageCacheEntry : NSObject {
+	@public
+	MMMDecodedImageCacheKey *_key;
+	UIImage *_image;
+	NSUInteger _cost;
+	__unsafe_unretained MMMDecodedImageCacheEntry *_prev;
+	__unsafe_unretained MMMDecodedImageCacheEntry *_next;
+}
+@end
+
+@implementation MMMDecodedImageCacheEntry
+@end
+
+@implementation MMMDecodedImageCache {
+	os_unfair_lock _lock;
+	NSMutableDictionary<MMMDecodedImageCacheKey *, MMMDecodedImageCacheEntry *> *_entries;
+	// The most and the least recently used entries.
+	__unsafe_unretained MMMDecodedImageCacheEntry *_head;
+	__unsafe_unretained MMMDecodedImageCacheEntry *_tail;
+	NSUInteger _totalCostLimit;
+}
+
+@synthesize totalCost = _totalCost;
+@synthesize numberOfHits = _numberOfHits;
+@synthesize numberOfMisses = _numberOfMisses;
+@synthesize numberOfEvictions = _numberOfEvictions;
+
++ (instancetype)shared {
+	static MMMDecodedImageCache *shared = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		shared = [[MMMDecodedImageCache alloc] init];
+	});
+	return shared;
+}
+
+- (id)initWithTotalCostLimit:(NSUInteger)totalCostLimit {
+
+	if (self = [super init]) {
+
+		_lock = OS_UNFAIR_LOCK_INIT;
+		_entries = [[NSMutableDictionary alloc] init];
+		_totalCostLimit = totalCostLimit;
+
+		[[NSNotificationCenter defaultCenter]
+			addObserver:self
+			selector:@selector(didReceiveMemoryWarning:)
+			name:UIApplicationDidReceiveMemoryWarningNotification
+			object:nil
+		];
+	}
+
+	return self;
+}
+
+- (id)init {
+	// 1/16 of the physical memory, but no more than 128MB: plenty for a couple of screens of photos.
+	return [self initWithTotalCostLimit:MIN([NSProcessInfo processInfo].physicalMemory / 16, 128 << 20)];
+}
+
+- (void)dealloc {
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)didReceiveMemoryWarning:(NSNotification *)notification {
+	[self handleMemoryPressureCritical:YES];
+}
+
++ (NSUInteger)costForImage:(UIImage *)image {
+
+	NSUInteger frameCost;
+	CGImageRef cgImage = image.CGImage;
+	if (cgImage) {
+		frameCost = CGImageGetBytesPerRow(cgImage) * CGImageGetHeight(cgImage);
+	} else {
+		// Not backed by a bitmap yet (e.g. CIImage-based), let's assume it would be a 32-bit one.
+		frameCost = (NSUInteger)(image.size.width * image.scale) * (NSUInteger)(image.size.height * image.scale) * 4;
+	}
+
+	return frameCost * MAX(1, image.images.count);
+}
+
+#pragma mark - The list
+
+- (void)unlink:(MMMDecodedImageCacheEntry *)entry {
+	if (entry->_prev)
+		entry->_prev->_next = entry->_next;
+	else
+		_head = entry->_next;
+	if (entry->_next)
+		entry->_next->_prev = entry->_prev;
+	else
+		_tail = entry->_prev;
+	entry->_prev = entry->_next = nil;
+}
+
+- (void)linkAtHead:(MMMDecodedImageCacheEntry *)entry {
+	entry->_prev = nil;
+	entry->_next = _head;
+	if (_head)
+		_head->_prev = entry;
+	_head = entry;
+	if (!_tail)
+		_tail = entry;
+}
+
+- (void)removeEntry:(MMMDecodedImageCacheEntry *)entry {
+	// The entry can go away together with its key while the dictionary is still using it.
+	MMMDecodedImageCacheKey *key = entry->_key;
+	[self unlink:entry];
+	_totalCost -= entry->_cost;
+	[_entries removeObjectForKey:key];
+}
+
+- (void)lockedTrimToCost:(NSUInteger)cost {
+	while (_totalCost > cost && _tail) {
+		[self removeEntry:_tail];
+		_numberOfEvictions++;
+	}
+}
+
+#pragma mark - Public
+
+- (UIImage *)imageForKey:(MMMDecodedImageCacheKey *)key {
+
+	os_unfair_lock_lock(&_lock);
+
+	MMMDecodedImageCacheEntry *entry = _entries[key];
+	UIImage *image = nil;
+	if (entry) {
+		_numberOfHits++;
+		if (entry != _head) {
+			[self unlink:entry];
+			[self linkAtHead:entry];
+		}
+		image = entry->_image;
+	} else {
+		_numberOfMisses++;
+	}
+
+	os_unfair_lock_unlock(&_lock);
+
+	return image;
+}
+
+- (void)setImage:(UIImage *)image forKey:(MMMDecodedImageCacheKey *)key {
+
+	// Outside of the lock as it can touch the image.
+	NSUInteger cost = [[self class] costForImage:image];
+
+	os_unfair_lock_lock(&_lock);
+
+	MMMDecodedImageCacheEntry *old = _entries[key];
+	if (old)
+		[self removeEntry:old];
+
+	if (cost <= _totalCostLimit) {
+		MMMDecodedImageCacheEntry *entry = [[MMMDecodedImageCacheEntry alloc] init];
+		entry->_key = [key copy];
+		entry->_image = image;
+		entry->_cost = cost;
+		_entries[entry->_key] = entry;
+		[self linkAtHead:entry];
+		_totalCost += cost;
+		[self lockedTrimToCost:_totalCostLimit];
+	}
+
+	os_unfair_lock_unlock(&_lock);
+}
+
+- (void)removeImageForKey:(MMMDecodedImageCacheKey *)key {
+	os_unfair_lock_lock(&_lock);
+	MMMDecodedImageCacheEntry *entry = _entries[key];
+	if (entry)
+		[self removeEntry:entry];
+	os_unfair_lock_unlock(&_lock);
+}
+
+- (void)removeAllImages {
+	os_unfair_lock_lock(&_lock);
+	_head = _tail = nil;
+	_totalCost = 0;
+	// The images are released outside of the lock.
+	NSMutableDictionary *entries = _entries;
+	_entries = [[NSMutableDictionary alloc] init];
+	os_unfair_lock_unlock(&_lock);
+	entries = nil;
+}
+
+- (void)trimToCost:(NSUInteger)cost {
+	os_unfair_lock_lock(&_lock);
+	[self lockedTrimToCost:cost];
+	os_unfair_lock_unlock(&_lock);
+}
+
+- (void)handleMemoryPressureCritical:(BOOL)critical {
+	os_unfair_lock_lock(&_lock);
+	[self lockedTrimToCost:critical ? 0 : _totalCostLimit / 2];
+	os_unfair_lock_unlock(&_lock);
+}
+
+- (NSUInteger)totalCostLimit {
+	os_unfair_lock_lock(&_lock);
+	NSUInteger result = _totalCostLimit;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+- (void)setTotalCostLimit:(NSUInteger)totalCostLimit {
+	os_unfair_lock_lock(&_lock);
+	_totalCostLimit = totalCostLimit;
+	[self lockedTrimToCost:_totalCostLimit];
+	os_unfair_lock_unlock(&_lock);
+}
+
+- (NSInteger)count {
+	os_unfair_lock_lock(&_lock);
+	NSInteger result = _entries.count;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+- (NSUInteger)totalCost {
+	os_unfair_lock_lock(&_lock);
+	NSUInteger result = _totalCost;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+- (NSInteger)numberOfHits {
+	os_unfair_lock_lock(&_lock);
+	NSInteger result = _numberOfHits;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+- (NSInteger)numberOfMisses {
+	os_unfair_lock_lock(&_lock);
+	NSInteger result = _numberOfMisses;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+- (NSInteger)numberOfEvictions {
+	os_unfair_lock_lock(&_lock);
+	NSInteger result = _numberOfEvictions;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+@end
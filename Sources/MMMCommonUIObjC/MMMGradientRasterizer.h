@@ -0,0 +1,56 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+@import UIKit;
+#import <simd/simd.h>
+
+#import "MMMAnimations.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*
+ * A minimal CPU gradient rasterizer for cases where we want to pre-bake gradients into bitmaps instead of
+ * drawing them via Core Graphics in `drawRect:`. None of the functions here touch UIKit, so they can be called
+ * from any thread.
+ *
+ * Gradients are defined by "ramps": colors sampled at `count` equally spaced points of the [0; 1] range,
+ * as non-premultiplied RGBA components within [0; 1]. The output is always premultiplied RGBA8 with 4x4 ordered
+ * dithering applied to avoid banding of subtle gradients like shadows.
+ */
+
+/**
+ * Fills the ramp with colors between `from` and `to` following the given curve
+ * (see `+[MMMAnimation curvedTimeForTime:curve:]`). The count should be at least 2.
+ */
+extern void MMMGradientRampFill(simd_float4 *ramp, NSInteger count, simd_float4 from, simd_float4 to, MMMAnimationCurve curve);
+
+/**
+ * Rasterizes a linear gradient going from `start` to `end` (in pixels, relative to the top left corner of the bitmap).
+ * The colors at the ends of the ramp are extended beyond the corresponding points.
+ */
+extern void MMMGradientRasterizeLinear(
+	uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow,
+	const simd_float4 *ramp, NSInteger rampCount,
+	simd_float2 start, simd_float2 end
+);
+
+/**
+ * Rasterizes a radial gradient of concentric circles around `center` going from `startRadius` to `endRadius`
+ * (in pixels). Unlike the linear one the gradient is not extended, i.e. pixels outside of the ring are transparent.
+ */
+extern void MMMGradientRasterizeRadial(
+	uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow,
+	const simd_float4 *ramp, NSInteger rampCount,
+	simd_float2 center, float startRadius, float endRadius
+);
+
+/**
+ * An image backed by the given premultiplied RGBA8 pixels, e.g. the ones produced by the rasterizer.
+ * The data is retained by the image, not copied.
+ */
+extern CGImageRef MMMCreateImageWithPremultipliedRGBA(NSData *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow)
+	CF_RETURNS_RETAINED;
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,110 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+#import "MMMGradientRasterizer.h"
+
+void MMMGradientRampFill(simd_float4 *ramp, NSInteger count, simd_float4 from, simd_float4 to, MMMAnimationCurve curve) {
+
+	NSCAssert(count >= 2, @"A ramp should have at least 2 entries");
+
+	for (NSInteger i = 0; i < count; i++) {
+		float t = (float)[MMMAnimation curvedTimeForTime:(CGFloat)i / (count - 1) curve:curve];
+		ramp[i] = simd_mix(from, to, t);
+	}
+}
+
+// 4x4 Bayer matrix, thresholds are (value + 0.5) / 16, so the average offset is exactly 0.5, i.e. rounding.
+static const float MMMGradientDitherThresholds[4][4] = {
+	{  0.5 / 16,  8.5 / 16,  2.5 / 16, 10.5 / 16 },
+	{ 12.5 / 16,  4.5 / 16, 14.5 / 16,  6.5 / 16 },
+	{  3.5 / 16, 11.5 / 16,  1.5 / 16,  9.5 / 16 },
+	{ 15.5 / 16,  7.5 / 16, 13.5 / 16,  5.5 / 16 }
+};
+
+/// The color of the ramp at the given time (clamped to [0; 1]).
+static inline simd_float4 MMMGradientRampSample(const simd_float4 *ramp, NSInteger count, float t) {
+	float x = simd_clamp(t, 0.0f, 1.0f) * (count - 1);
+	NSInteger i = MIN((NSInteger)x, count - 2);
+	return simd_mix(ramp[i], ramp[i + 1], x - i);
+}
+
+/// Premultiplies, dithers and stores the color into the given pixel.
+static inline void MMMGradientStore(uint8_t *pixel, simd_float4 color, float threshold) {
+	simd_float4 premultiplied = simd_make_float4(color.xyz * color.w, color.w);
+	simd_float4 v = simd_clamp(simd_floor(premultiplied * 255.0f + threshold), 0.0f, 255.0f);
+	simd_uchar4 c = simd_uchar(v);
+	memcpy(pixel, &c, 4);
+}
+
+void MMMGradientRasterizeLinear(
+	uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow,
+	const simd_float4 *ramp, NSInteger rampCount,
+	simd_float2 start, simd_float2 end
+) {
+	simd_float2 direction = end - start;
+	float lengthSquared = simd_length_squared(direction);
+	// Degenerate gradients are filled with the start color.
+	simd_float2 step = lengthSquared > 0 ? direction / lengthSquared : simd_make_float2(0, 0);
+
+	for (NSInteger y = 0; y < height; y++) {
+
+		uint8_t *row = pixels + y * bytesPerRow;
+		const float *thresholds = MMMGradientDitherThresholds[y & 3];
+
+		// The parameter changes linearly along the row, so only one dot product per row is needed.
+		float t = simd_dot(simd_make_float2(.5f, y + .5f) - start, step);
+
+		for (NSInteger x = 0; x < width; x++) {
+			MMMGradientStore(row + x * 4, MMMGradientRampSample(ramp, rampCount, t), thresholds[x & 3]);
+			t += step.x;
+		}
+	}
+}
+
+void MMMGradientRasterizeRadial(
+	uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow,
+	const simd_float4 *ramp, NSInteger rampCount,
+	simd_float2 center, float startRadius, float endRadius
+) {
+	float thickness = endRadius - startRadius;
+
+	for (NSInteger y = 0; y < height; y++) {
+
+		uint8_t *row = pixels + y * bytesPerRow;
+		const float *thresholds = MMMGradientDitherThresholds[y & 3];
+
+		for (NSInteger x = 0; x < width; x++) {
+
+			float r = simd_distance(simd_make_float2(x + .5f, y + .5f), center);
+			float t = thickness != 0 ? (r - startRadius) / thickness : -1;
+
+			if (t < 0 || t > 1) {
+				memset(row + x * 4, 0, 4);
+			} else {
+				MMMGradientStore(row + x * 4, MMMGradientRampSample(ramp, rampCount, t), thresholds[x & 3]);
+			}
+		}
+	}
+}
+
+CGImageRef MMMCreateImageWithPremultipliedRGBA(NSData *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow) {
+
+	CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)pixels);
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+
+	CGImageRef image = CGImageCreate(
+		width, height,
+		8, 32, bytesPerRow,
+		colorSpace,
+		kCGBitmapByteOrderDefault | kCGImageAlphaPremultipliedLast,
+		provider,
+		NULL, NO, kCGRenderingIntentDefault
+	);
+
+	CGColorSpaceRelease(colorSpace);
+	CGDataProviderRelease(provider);
+
+	return image;
+}
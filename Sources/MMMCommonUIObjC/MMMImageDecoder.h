@@ -0,0 +1,80 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+@import UIKit;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, MMMImageDecoderContentMode) {
+	/** The image is made small enough to fit into the target size. */
+	MMMImageDecoderContentModeFit,
+	/** The image is made small enough to cover the target size, i.e. nothing is cropped. */
+	MMMImageDecoderContentModeFill
+};
+
+/**
+ * A version of the image that is decompressed and downsampled (never upsampled) to the given size in pixels,
+ * so the image can be displayed without decoding it on the main thread during the first render
+ * and without keeping more pixels than the view can show.
+ *
+ * The size of the result in points is the same as of the source image (only its scale changes),
+ * so using it instead of the source does not affect the layout.
+ *
+ * A zero target size means the image is only decoded. Can be called from any thread.
+ */
+extern UIImage *MMMImageDecoderDecodedImage(UIImage *image, CGSize pixelSize, MMMImageDecoderContentMode contentMode);
+
+/** A request to decode an image. */
+@interface MMMImageDecoderRequest : NSObject
+
+/** The completion block of the request won't be called after this. Does nothing if the request is done already. */
+- (void)cancel;
+
+- (id)init NS_UNAVAILABLE;
+
+@end
+
+typedef void (^MMMImageDecoderCompletion)(UIImage *image);
+
+/**
+ * Decodes and downsamples images (see `MMMImageDecoderDecodedImage()`) on background threads before they are shown.
+ *
+ * No more than `maxConcurrentDecodes` images are processed at the same time; the most recent requests are served
+ * first as they usually correspond to the views that have just appeared. When there are more than `maxPendingDecodes`
+ * requests waiting, the oldest ones are completed right away with their source images as is (back-pressure):
+ * better to let UIKit decode them than to keep views empty for long.
+ */
+@interface MMMImageDecoder : NSObject
+
+/** The instance used by default. */
++ (instancetype)shared;
+
+- (id)initWithMaxConcurrentDecodes:(NSInteger)maxConcurrentDecodes
+	maxPendingDecodes:(NSInteger)maxPendingDecodes NS_DESIGNATED_INITIALIZER;
+
+/** A decoder using up to 2 threads and keeping up to 32 pending requests. */
+- (id)init;
+
+@property (nonatomic, readonly) NSInteger maxConcurrentDecodes;
+@property (nonatomic, readonly) NSInteger maxPendingDecodes;
+
+/** Schedules decoding of the image. The completion is called on the main queue unless the request is cancelled. */
+- (MMMImageDecoderRequest *)decodeImage:(UIImage *)image
+	pixelSize:(CGSize)pixelSize
+	contentMode:(MMMImageDecoderContentMode)contentMode
+	completion:(MMMImageDecoderCompletion)completion;
+
+/** The number of requests waiting to be processed. */
+@property (nonatomic, readonly) NSInteger numberOfPendingDecodes;
+
+/** The number of images decoded so far. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfDecodedImages;
+
+/** The number of requests completed without decoding because of too many pending ones. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfSkippedDecodes;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,259 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+#import "MMMImageDecoder.h"
+
+#import <os/lock.h>
+
+UIImage *MMMImageDecoderDecodedImage(UIImage *image, CGSize pixelSize, MMMImageDecoderContentMode contentMode) {
+
+	CGSize size = image.size;
+	if (!(size.width > 0 && size.height > 0))
+		return image;
+
+	CGFloat sourceWidth = size.width * image.scale;
+	CGFloat sourceHeight = size.height * image.scale;
+
+	CGFloat factor = 1;
+	if (pixelSize.width > 0 && pixelSize.height > 0) {
+		CGFloat fx = pixelSize.width / sourceWidth;
+		CGFloat fy = pixelSize.height / sourceHeight;
+		factor = MIN(1, contentMode == MMMImageDecoderContentModeFill ? MAX(fx, fy) : MIN(fx, fy));
+	}
+
+	size_t width = (size_t)MAX(1, round(sourceWidth * factor));
+	size_t height = (size_t)MAX(1, round(sourceHeight * factor));
+
+	CGImageAlphaInfo alphaInfo = image.CGImage ? CGImageGetAlphaInfo(image.CGImage) : kCGImageAlphaPremultipliedFirst;
+	BOOL opaque = alphaInfo == kCGImageAlphaNone || alphaInfo == kCGImageAlphaNoneSkipFirst || alphaInfo == kCGImageAlphaNoneSkipLast;
+
+	// The native format of the GPU, so Core Animation does not have to convert it again.
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+	CGContextRef context = CGBitmapContextCreate(
+		NULL, width, height, 8, 0, colorSpace,
+		kCGBitmapByteOrder32Host | (opaque ? kCGImageAlphaNoneSkipFirst : kCGImageAlphaPremultipliedFirst)
+	);
+	CGColorSpaceRelease(colorSpace);
+	if (!context)
+		return image;
+
+	CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+
+	// UIKit's coordinate system in points of the source image, so -drawInRect: can take care of the orientation.
+	CGContextTranslateCTM(context, 0, height);
+	CGContextScaleCTM(context, width / size.width, -(height / size.height));
+
+	UIGraphicsPushContext(context);
+	[image drawInRect:CGRectMake(0, 0, size.width, size.height)];
+	UIGraphicsPopContext();
+
+	CGImageRef decoded = CGBitmapContextCreateImage(context);
+	CGContextRelease(context);
+	if (!decoded)
+		return image;
+
+	UIImage *result = [UIImage imageWithCGImage:decoded scale:width / size.width orientation:UIImageOrientationUp];
+	CGImageRelease(decoded);
+
+	return result;
+}
+
+//
+//
+//
+@interface MMMImageDecoderRequest () {
+	@public
+	UIImage *_image;
+	CGSize _pixelSize;
+	MMMImageDecoderContentMode _contentMode;
+	MMMImageDecoderCompletion _completion;
+	BOOL _cancelled;
+	BOOL _done;
+	__weak MMMImageDecoder *_decoder;
+}
+@end
+
+@interface MMMImageDecoder ()
+- (void)cancelRequest:(MMMImageDecoderRequest *)request;
+@end
+
+@implementation MMMImageDecoderRequest
+
+- (id)initPrivately {
+	return [super init];
+}
+
+- (void)cancel {
+	[_decoder cancelRequest:self];
+}
+
+@end
+
+//
+//
+//
+@implementation MMMImageDecoder {
+	os_unfair_lock _lock;
+	// The most recent requests are at the end.
+	NSMutableArray<MMMImageDecoderRequest *> *_pending;
+	NSInteger _numberOfRunningDecodes;
+	dispatch_queue_t _queue;
+}
+
+@synthesize numberOfDecodedImages = _numberOfDecodedImages;
+@synthesize numberOfSkippedDecodes = _numberOfSkippedDecodes;
+
++ (instancetype)shared {
+	static MMMImageDecoder *shared = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		shared = [[MMMImageDecoder alloc] init];
+	});
+	return shared;
+}
+
+- (id)initWithMaxConcurrentDecodes:(NSInteger)maxConcurrentDecodes maxPendingDecodes:(NSInteger)maxPendingDecodes {
+
+	if (self = [super init]) {
+
+		NSAssert(maxConcurrentDecodes > 0 && maxPendingDecodes >= 0, @"");
+
+		_maxConcurrentDecodes = maxConcurrentDecodes;
+		_maxPendingDecodes = maxPendingDecodes;
+
+		_lock = OS_UNFAIR_LOCK_INIT;
+		_pending = [[NSMutableArray alloc] init];
+		_queue = dispatch_queue_create(
+			"MMMImageDecoder",
+			dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_CONCURRENT, QOS_CLASS_USER_INITIATED, 0)
+		);
+	}
+
+	return self;
+}
+
+- (id)init {
+	return [self initWithMaxConcurrentDecodes:2 maxPendingDecodes:32];
+}
+
+- (MMMImageDecoderRequest *)decodeImage:(UIImage *)image
+	pixelSize:(CGSize)pixelSize
+	contentMode:(MMMImageDecoderContentMode)contentMode
+	completion:(MMMImageDecoderCompletion)completion
+{
+	MMMImageDecoderRequest *request = [[MMMImageDecoderRequest alloc] initPrivately];
+	request->_image = image;
+	request->_pixelSize = pixelSize;
+	request->_contentMode = contentMode;
+	request->_completion = [completion copy];
+	request->_decoder = self;
+
+	NSMutableArray<MMMImageDecoderRequest *> *skipped = [[NSMutableArray alloc] init];
+
+	os_unfair_lock_lock(&_lock);
+	[_pending addObject:request];
+	while (_pending.count > _maxPendingDecodes) {
+		MMMImageDecoderRequest *oldest = _pending.firstObject;
+		[_pending removeObjectAtIndex:0];
+		[skipped addObject:oldest];
+		_numberOfSkippedDecodes++;
+	}
+	os_unfair_lock_unlock(&_lock);
+
+	for (MMMImageDecoderRequest *r in skipped) {
+		[self finishRequest:r withImage:r->_image];
+	}
+
+	[self startPendingDecodes];
+
+	return request;
+}
+
+- (void)startPendingDecodes {
+
+	while (YES) {
+
+		os_unfair_lock_lock(&_lock);
+		MMMImageDecoderRequest *request = nil;
+		if (_numberOfRunningDecodes < _maxConcurrentDecodes) {
+			request = _pending.lastObject;
+			if (request) {
+				[_pending removeLastObject];
+				_numberOfRunningDecodes++;
+			}
+		}
+		os_unfair_lock_unlock(&_lock);
+
+		if (!request)
+			break;
+
+		dispatch_async(_queue, ^{
+
+			os_unfair_lock_lock(&self->_lock);
+			BOOL cancelled = request->_cancelled;
+			os_unfair_lock_unlock(&self->_lock);
+
+			UIImage *decoded = nil;
+			if (!cancelled) {
+				decoded = MMMImageDecoderDecodedImage(request->_image, request->_pixelSize, request->_contentMode);
+			}
+
+			os_unfair_lock_lock(&self->_lock);
+			self->_numberOfRunningDecodes--;
+			if (decoded)
+				self->_numberOfDecodedImages++;
+			os_unfair_lock_unlock(&self->_lock);
+
+			if (decoded)
+				[self finishRequest:request withImage:decoded];
+
+			[self startPendingDecodes];
+		});
+	}
+}
+
+- (void)finishRequest:(MMMImageDecoderRequest *)request withImage:(UIImage *)image {
+	dispatch_async(dispatch_get_main_queue(), ^{
+		os_unfair_lock_lock(&self->_lock);
+		BOOL cancelled = request->_cancelled;
+		request->_done = YES;
+		os_unfair_lock_unlock(&self->_lock);
+		if (!cancelled)
+			request->_completion(image);
+		request->_completion = nil;
+	});
+}
+
+- (void)cancelRequest:(MMMImageDecoderRequest *)request {
+	os_unfair_lock_lock(&_lock);
+	if (!request->_done) {
+		request->_cancelled = YES;
+		[_pending removeObjectIdenticalTo:request];
+	}
+	os_unfair_lock_unlock(&_lock);
+}
+
+- (NSInteger)numberOfPendingDecodes {
+	os_unfair_lock_lock(&_lock);
+	NSInteger result = _pending.count;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+- (NSInteger)numberOfDecodedImages {
+	os_unfair_lock_lock(&_lock);
+	NSInteger result = _numberOfDecodedImages;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+- (NSInteger)numberOfSkippedDecodes {
+	os_unfair_lock_lock(&_lock);
+	NSInteger result = _numberOfSkippedDecodes;
+	os_unfair_lock_unlock(&_lock);
+	return result;
+}
+
+@end
@@ -0,0 +1,126 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+@import UIKit;
+
+#import "MMMDecodedImageCache.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^MMMImageRequestCompletion)(UIImage * _Nullable image, NSError * _Nullable error);
+
+/** Called with intermediate (e.g. low quality) versions of the image before the final one. */
+typedef void (^MMMImageRequestProgress)(UIImage *image);
+
+typedef NS_ENUM(NSInteger, MMMProgressiveImageDeliveryAction) {
+	/** Nothing to pass to the clients. */
+	MMMProgressiveImageDeliveryActionIgnore,
+	/** The image should be published as an intermediate one. */
+	MMMProgressiveImageDeliveryActionProgress,
+	/** The request is done: successfully if there is an image, failed otherwise. */
+	MMMProgressiveImageDeliveryActionComplete
+};
+
+/**
+ * Tracks a request delivering images possibly several times (like `PHImageManager` in the opportunistic mode)
+ * and tells which of them are intermediate and which one is final, so it's possible to stick to the simple
+ * "progress, progress, ..., completion" sequence:
+ * - degraded images are intermediate unless the request is complete already;
+ * - degraded deliveries without images are ignored as the final one is still expected;
+ * - the first non-degraded delivery completes the request (a failure if there is no image) and anything after it
+ *   is ignored.
+ */
+@interface MMMProgressiveImageDelivery : NSObject
+
+- (MMMProgressiveImageDeliveryAction)actionForImage:(nullable UIImage *)image degraded:(BOOL)degraded;
+
+/** YES, if at least one intermediate image was delivered. */
+@property (nonatomic, readonly) BOOL hasIntermediateImage;
+
+/** YES, when the final delivery has happened. */
+@property (nonatomic, readonly, getter=isComplete) BOOL complete;
+
+@end
+
+/** Performs the actual image requests for `MMMImageRequestCoalescer`, e.g. via `PHImageManager`. */
+@protocol MMMImageRequestPerformer <NSObject>
+
+/**
+ * Begins loading the image for the given key. The completion can be called on any thread, but only once,
+ * and is not expected to be called after the request is cancelled (it's ignored if it is).
+ * The returned object is passed to `cancelImageRequest:` if the image is not needed anymore.
+ *
+ * The progress block is passed only when some clients are interested in intermediate images. It can be called
+ * any number of times (on any thread as well) before the completion, but should not be called after it.
+ */
+- (id)startImageRequestForKey:(MMMDecodedImageCacheKey *)key
+	progress:(nullable MMMImageRequestProgress)progress
+	completion:(MMMImageRequestCompletion)completion;
+
+- (void)cancelImageRequest:(id)request;
+
+@end
+
+/** A request of a single client of `MMMImageRequestCoalescer`. */
+@interface MMMImageRequestSubscription : NSObject
+
+/**
+ * The completion of this subscription won't be called after this. The actual request is cancelled
+ * when there are no other subscriptions interested in it.
+ */
+- (void)cancel;
+
+- (id)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ * Makes sure that identical image requests (the same source, size and content mode) coming from different clients
+ * (e.g. several cells showing the same image) are performed only once, that no more than a certain number
+ * of requests run at the same time and that requests nobody is interested in anymore are cancelled.
+ *
+ * Should be used from the main thread only, completions are called on the main thread as well.
+ */
+@interface MMMImageRequestCoalescer : NSObject
+
+- (id)initWithPerformer:(id<MMMImageRequestPerformer>)performer
+	maxConcurrentRequests:(NSInteger)maxConcurrentRequests NS_DESIGNATED_INITIALIZER;
+
+- (id)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) NSInteger maxConcurrentRequests;
+
+/**
+ * Joins the request for the given key that is in flight already or schedules a new one.
+ * Requests waiting for their turn are started in the order they were made.
+ */
+- (MMMImageRequestSubscription *)requestImageForKey:(MMMDecodedImageCacheKey *)key
+	completion:(MMMImageRequestCompletion)completion;
+
+/**
+ * Same as `requestImageForKey:completion:`, but intermediate images are delivered as well, if the performer
+ * supports them. When joining a request that has delivered an intermediate image already, the latest one
+ * is passed to the progress block right away (but still asynchronously).
+ * (A request that was started without progress does not deliver intermediate images to anybody.)
+ */
+- (MMMImageRequestSubscription *)requestImageForKey:(MMMDecodedImageCacheKey *)key
+	progress:(nullable MMMImageRequestProgress)progress
+	completion:(MMMImageRequestCompletion)completion;
+
+/** The number of requests that are running or waiting for their turn. */
+@property (nonatomic, readonly) NSInteger numberOfRequestsInFlight;
+
+/** The number of requests passed to the performer. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfStartedRequests;
+
+/** The number of times a request in flight was joined instead of making a new one. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfCoalescedRequests;
+
+/** The number of requests dropped (before or after they were started) because nobody needed them. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfCancelledRequests;
+
+@end
+
+NS_ASSUME_NONNULL_END
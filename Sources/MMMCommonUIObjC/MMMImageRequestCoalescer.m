@@ -0,0 +1,258 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+#import "MMMImageRequestCoalescer.h"
+
+@implementation MMMProgressiveImageDelivery
+
+- (MMMProgressiveImageDeliveryAction)actionForImage:(UIImage *)image degraded:(BOOL)degraded {
+
+	if (_complete)
+		return MMMProgressiveImageDeliveryActionIgnore;
+
+	if (degraded) {
+		if (!image)
+			return MMMProgressiveImageDeliveryActionIgnore;
+		_hasIntermediateImage = YES;
+		return MMMProgressiveImageDeliveryActionProgress;
+	}
+
+	_complete = YES;
+	return MMMProgressiveImageDeliveryActionComplete;
+}
+
+@end
+
+//
+//
+//
+@class MMMImageRequestFlight;
+
+@interface MMMImageRequestCoalescer ()
+- (void)cancelSubscription:(MMMImageRequestSubscription *)subscription;
+@end
+
+@interface MMMImageRequestSubscription () {
+	@public
+	MMMImageRequestCompletion _completion;
+	MMMImageRequestProgress _progress;
+	__weak MMMImageRequestCoalescer *_coalescer;
+	__weak MMMImageRequestFlight *_flight;
+	BOOL _cancelled;
+}
+@end
+
+@implementation MMMImageRequestSubscription
+
+- (id)initPrivately {
+	return [super init];
+}
+
+- (void)cancel {
+	[_coalescer cancelSubscription:self];
+}
+
+@end
+
+/// A single actual request shared by one or more subscriptions.
+@interface MMMImageRequestFlight : NSObject {
+	@public
+	MMMDecodedImageCacheKey *_key;
+	NSMutableArray<MMMImageRequestSubscription *> *_subscriptions;
+	// YES, when the request is passed to the performer, i.e. the flight is not waiting for its turn anymore.
+	BOOL _started;
+	// What the performer has returned for the request.
+	id _request;
+	BOOL _finished;
+	// The latest intermediate image, if any.
+	UIImage *_intermediateImage;
+}
+@end
+
+@implementation MMMImageRequestFlight
+@end
+
+//
+//
+//
+@implementation MMMImageRequestCoalescer {
+	id<MMMImageRequestPerformer> _performer;
+	NSMutableDictionary<MMMDecodedImageCacheKey *, MMMImageRequestFlight *> *_flights;
+	NSMutableArray<MMMImageRequestFlight *> *_waitingFlights;
+	NSInteger _numberOfRunningRequests;
+}
+
+- (id)initWithPerformer:(id<MMMImageRequestPerformer>)performer maxConcurrentRequests:(NSInteger)maxConcurrentRequests {
+
+	if (self = [super init]) {
+
+		NSAssert(maxConcurrentRequests > 0, @"");
+
+		_performer = performer;
+		_maxConcurrentRequests = maxConcurrentRequests;
+
+		_flights = [[NSMutableDictionary alloc] init];
+		_waitingFlights = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (NSInteger)numberOfRequestsInFlight {
+	return _flights.count;
+}
+
+- (MMMImageRequestSubscription *)requestImageForKey:(MMMDecodedImageCacheKey *)key completion:(MMMImageRequestCompletion)completion {
+	return [self requestImageForKey:key progress:nil completion:completion];
+}
+
+- (MMMImageRequestSubscription *)requestImageForKey:(MMMDecodedImageCacheKey *)key
+	progress:(MMMImageRequestProgress)progress
+	completion:(MMMImageRequestCompletion)completion
+{
+	NSAssert([NSThread isMainThread], @"");
+
+	MMMImageRequestFlight *flight = _flights[key];
+	if (flight) {
+		_numberOfCoalescedRequests++;
+	} else {
+		flight = [[MMMImageRequestFlight alloc] init];
+		flight->_key = key;
+		flight->_subscriptions = [[NSMutableArray alloc] init];
+		_flights[key] = flight;
+		[_waitingFlights addObject:flight];
+	}
+
+	MMMImageRequestSubscription *subscription = [[MMMImageRequestSubscription alloc] initPrivately];
+	subscription->_completion = [completion copy];
+	subscription->_progress = [progress copy];
+	subscription->_coalescer = self;
+	subscription->_flight = flight;
+	[flight->_subscriptions addObject:subscription];
+
+	if (progress && flight->_intermediateImage) {
+		UIImage *image = flight->_intermediateImage;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (!subscription->_cancelled && subscription->_progress)
+				subscription->_progress(image);
+		});
+	}
+
+	[self startWaitingFlights];
+
+	return subscription;
+}
+
+- (void)startWaitingFlights {
+
+	while (_numberOfRunningRequests < _maxConcurrentRequests && _waitingFlights.count > 0) {
+
+		MMMImageRequestFlight *flight = _waitingFlights.firstObject;
+		[_waitingFlights removeObjectAtIndex:0];
+
+		flight->_started = YES;
+		_numberOfRunningRequests++;
+		_numberOfStartedRequests++;
+
+		// Intermediate images are requested only if somebody needs them.
+		BOOL progressive = NO;
+		for (MMMImageRequestSubscription *s in flight->_subscriptions) {
+			progressive |= (s->_progress != nil);
+		}
+
+		typeof(self) __weak weakSelf = self;
+		flight->_request = [_performer
+			startImageRequestForKey:flight->_key
+			progress:!progressive ? nil : ^(UIImage *image) {
+				dispatch_async(dispatch_get_main_queue(), ^{
+					[weakSelf progressFlight:flight image:image];
+				});
+			}
+			completion:^(UIImage *image, NSError *error) {
+				dispatch_async(dispatch_get_main_queue(), ^{
+					[weakSelf finishFlight:flight image:image error:error];
+				});
+			}
+		];
+	}
+}
+
+- (void)removeFlight:(MMMImageRequestFlight *)flight {
+	flight->_finished = YES;
+	if (_flights[flight->_key] == flight)
+		[_flights removeObjectForKey:flight->_key];
+}
+
+- (void)progressFlight:(MMMImageRequestFlight *)flight image:(UIImage *)image {
+
+	if (flight->_finished)
+		return;
+
+	flight->_intermediateImage = image;
+
+	for (MMMImageRequestSubscription *s in [flight->_subscriptions copy]) {
+		// A progress block can cancel other subscriptions.
+		if (!s->_cancelled && s->_progress)
+			s->_progress(image);
+	}
+}
+
+- (void)finishFlight:(MMMImageRequestFlight *)flight image:(UIImage *)image error:(NSError *)error {
+
+	if (flight->_finished) {
+		// Cancelled already.
+		return;
+	}
+
+	[self removeFlight:flight];
+	_numberOfRunningRequests--;
+
+	NSArray<MMMImageRequestSubscription *> *subscriptions = [flight->_subscriptions copy];
+	[flight->_subscriptions removeAllObjects];
+	for (MMMImageRequestSubscription *s in subscriptions) {
+		// A completion can cancel other subscriptions.
+		if (!s->_cancelled) {
+			s->_cancelled = YES;
+			MMMImageRequestCompletion completion = s->_completion;
+			s->_completion = nil;
+			s->_progress = nil;
+			completion(image, error);
+		}
+	}
+
+	[self startWaitingFlights];
+}
+
+- (void)cancelSubscription:(MMMImageRequestSubscription *)subscription {
+
+	NSAssert([NSThread isMainThread], @"");
+
+	if (subscription->_cancelled)
+		return;
+	subscription->_cancelled = YES;
+	subscription->_completion = nil;
+	subscription->_progress = nil;
+
+	MMMImageRequestFlight *flight = subscription->_flight;
+	if (!flight || flight->_finished)
+		return;
+
+	[flight->_subscriptions removeObjectIdenticalTo:subscription];
+	if (flight->_subscriptions.count > 0)
+		return;
+
+	// Nobody is interested in this one anymore.
+	_numberOfCancelledRequests++;
+	[self removeFlight:flight];
+	if (flight->_started) {
+		[_performer cancelImageRequest:flight->_request];
+		_numberOfRunningRequests--;
+		[self startWaitingFlights];
+	} else {
+		[_waitingFlights removeObjectIdenticalTo:flight];
+	}
+}
+
+@end
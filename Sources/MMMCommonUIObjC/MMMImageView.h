@@ -29,6 +29,15 @@ NS_ASSUME_NONNULL_BEGIN
 /** Convenience initializer. */
 - (id)initWithImage:(nullable UIImage *)image;
 
+/** How many times the aspect ratio constraint was (re)created. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfAspectRatioConstraintUpdates;
+
+/**
+ * How many times the aspect ratio constraint was kept because the ratio did not change enough to affect
+ * the layout by more than a fraction of a pixel. For diagnostics only.
+ */
+@property (nonatomic, readonly) NSInteger numberOfAvoidedAspectRatioConstraintUpdates;
+
 - (id)initWithFrame:(CGRect)frame NS_UNAVAILABLE;
 - (id)initWithCoder:(NSCoder *)aDecoder NS_UNAVAILABLE;
 
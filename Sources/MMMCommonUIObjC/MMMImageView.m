@@ -15,6 +15,16 @@
 	UIImageView *_imageView;
 
 	NSLayoutConstraint *_aspectRatioConstraint;
+	CGFloat _aspectRatio;
+
+	// Versions of our images without alignment rect insets, created on demand as -imageWithAlignmentRectInsets:
+	// returns a new wrapper every time.
+	UIImage *_strippedImage;
+	UIImage *_strippedHighlightedImage;
+
+	// The intrinsic size corresponding to the image displayed last time, to avoid invalidating the layout
+	// when switching between images of the same size (e.g. when highlighting).
+	CGSize _lastIntrinsicSize;
 }
 
 - (id)init {
@@ -51,23 +61,52 @@
 	return self.highlighted ? (_highlightedImage ?: _image) : _image;
 }
 
+static UIImage *MMMImageViewStrippedImage(UIImage *image) {
+	if (!image || UIEdgeInsetsEqualToEdgeInsets(image.alignmentRectInsets, UIEdgeInsetsZero))
+		return image;
+	return [image imageWithAlignmentRectInsets:UIEdgeInsetsZero];
+}
+
+- (UIImage *)currentStrippedImage {
+	if (self.highlighted && _highlightedImage) {
+		if (!_strippedHighlightedImage)
+			_strippedHighlightedImage = MMMImageViewStrippedImage(_highlightedImage);
+		return _strippedHighlightedImage;
+	} else {
+		if (!_strippedImage)
+			_strippedImage = MMMImageViewStrippedImage(_image);
+		return _strippedImage;
+	}
+}
+
 - (void)imageDidChange {
 
 	// Don't show it alignment rect, it cannot handle it.
-	_imageView.image = [[self currentImage] imageWithAlignmentRectInsets:UIEdgeInsetsZero];
+	_imageView.image = [self currentStrippedImage];
 
-	[self invalidateIntrinsicContentSize];
-	[self setNeedsUpdateConstraints];
+	CGSize intrinsicSize = [self intrinsicContentSize];
+	if (!CGSizeEqualToSize(intrinsicSize, _lastIntrinsicSize)) {
+		_lastIntrinsicSize = intrinsicSize;
+		[self invalidateIntrinsicContentSize];
+		[self setNeedsUpdateConstraints];
+	}
+	// The insets can be different even if the size is the same.
 	[self setNeedsLayout];
 }
 
 - (void)setImage:(UIImage *)image {
-	_image = image;
+	if (_image != image) {
+		_image = image;
+		_strippedImage = nil;
+	}
 	[self imageDidChange];
 }
 
 - (void)setHighlightedImage:(UIImage *)highlightedImage {
-	_highlightedImage = highlightedImage;
+	if (_highlightedImage != highlightedImage) {
+		_highlightedImage = highlightedImage;
+		_strippedHighlightedImage = nil;
+	}
 	[self imageDidChange];
 }
 
@@ -82,19 +121,34 @@
 
 	[super updateConstraints];
 
-	_aspectRatioConstraint.active = NO;
-
-	if (![self currentImage])
+	CGSize s = [self intrinsicContentSize];
+	if (![self currentImage] || !(s.width > 0 && s.height > 0)) {
+		_aspectRatioConstraint.active = NO;
+		_aspectRatioConstraint = nil;
 		return;
+	}
 
-	CGSize s = [self intrinsicContentSize];
+	CGFloat aspectRatio = s.width / s.height;
+
+	if (_aspectRatioConstraint) {
+		// Keeping the constraint if the new ratio would change our width by less than half a pixel.
+		CGFloat height = MAX(s.height, self.bounds.size.height);
+		if (fabs(aspectRatio - _aspectRatio) * height * MMMPixelScale() < 0.5) {
+			_numberOfAvoidedAspectRatioConstraintUpdates++;
+			return;
+		}
+		_aspectRatioConstraint.active = NO;
+	}
+
+	_aspectRatio = aspectRatio;
 	_aspectRatioConstraint = [NSLayoutConstraint
 		constraintWithItem:self attribute:NSLayoutAttributeWidth
 		relatedBy:NSLayoutRelationEqual
 		toItem:self attribute:NSLayoutAttributeHeight
-		multiplier:s.width / s.height constant:0
+		multiplier:aspectRatio constant:0
 	];
 	_aspectRatioConstraint.active = YES;
+	_numberOfAspectRatioConstraintUpdates++;
 }
 
 - (void)layoutSubviews {
@@ -41,6 +41,22 @@ typedef NS_ENUM(NSInteger, MMMKeyboardState) {
 /** The current state of the keyboard. */
 @property (nonatomic, readonly) MMMKeyboardState state;
 
+/**
+ * The frame of the keyboard in screen coordinates as it should be on the current display frame.
+ *
+ * Unlike the target frame used by `boundsNotCoveredByKeyboardForView:` and friends, this one follows
+ * the keyboard while it animates (using the duration and the curve of the corresponding notification and
+ * `MMMAnimator`), as well as when it floats around or changes its height. Observers implementing
+ * `keyboardDidUpdateFrame:` are notified on every change.
+ *
+ * Note that it does not follow the keyboard while it's being dragged by the user (e.g. with
+ * `UIScrollViewKeyboardDismissModeInteractive`): UIKit does not report positions in between, so the frame
+ * changes only when the keyboard is released and animates to its final position.
+ *
+ * It is `CGRectNull` until the first notification about the keyboard is received.
+ */
+@property (nonatomic, readonly) CGRect frame;
+
 /** 
  * In case the keyboard is visible, then bounds of the largest top part of the view not covered by the keyboard;
  * in case it's hidden, then unchanged bounds of the view.
@@ -81,6 +97,16 @@ typedef NS_ENUM(NSInteger, MMMKeyboardState) {
 	willChangeStateWithAnimationDuration:(NSTimeInterval)duration
 	curve:(UIViewAnimationCurve)curve;
 
+@optional
+
+/**
+ * Called every display frame while the keyboard moves, see `MMMKeyboard#frame`.
+ *
+ * This is meant for custom views following the keyboard frame by frame (e.g. a bar sitting on top of it);
+ * don't trigger Auto Layout passes here unless you really need it.
+ */
+- (void)keyboardDidUpdateFrame:(MMMKeyboard *)keyboard;
+
 @end
 
 /**
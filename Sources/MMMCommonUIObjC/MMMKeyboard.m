@@ -5,12 +5,48 @@
 
 #import "MMMKeyboard.h"
 
+#import "MMMAnimations.h"
 #import "MMMObserverHub.h"
 
+@interface MMMKeyboard ()
+@property (nonatomic, readwrite) CGRect frame;
+@end
+
+@interface MMMKeyboardLayoutHelper ()
+
+/// The view the guide belongs to (if it's still alive).
+- (nullable UIView *)view;
+
+/// Sets the height of the guide's constraint unless it has this value already.
+- (void)setCoveredHeight:(CGFloat)height;
+
+@end
+
+/// The height of the bottom part of the given rect covered by a keyboard with the given top edge
+/// (both in the same coordinates).
+static inline CGFloat MMMKeyboardCoveredHeight(CGRect rect, CGFloat keyboardTop) {
+	if (CGRectGetMaxY(rect) <= keyboardTop) {
+		// The keyboard is far below the view.
+		return 0;
+	} else {
+		// The keyboard is covering the view partially or wholly.
+		return rect.size.height - MAX(keyboardTop - CGRectGetMinY(rect), 0);
+	}
+}
+
 @implementation MMMKeyboard {
+
 	MMMObserverHub<id<MMMKeyboardObserver>> *_observerHub;
 	MMMObserverHub<id<MMMKeyboardObserver>> *_earlyObserverHub;
+
+	// The frame the keyboard is going to have after the current animation.
 	CGRect _endFrame;
+
+	// Drives `frame` while the keyboard animates.
+	MMMAnimationHandle *_frameAnimation;
+
+	// All instances of MMMKeyboardLayoutHelper, they are updated in one pass before any observers are notified.
+	NSHashTable<MMMKeyboardLayoutHelper *> *_layoutHelpers;
 }
 
 + (instancetype)shared {
@@ -30,8 +66,13 @@
 		_observerHub = [[MMMObserverHub alloc] initWithObservable:self];
 		_earlyObserverHub = [[MMMObserverHub alloc] initWithObservable:self];
 
+		_frame = CGRectNull;
+
+		_layoutHelpers = [NSHashTable weakObjectsHashTable];
+
 		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(keyboardWillShow:) name:UIKeyboardWillShowNotification object:nil];
 		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(keyboardWillHide:) name:UIKeyboardWillHideNotification object:nil];
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(keyboardWillChangeFrame:) name:UIKeyboardWillChangeFrameNotification object:nil];
 	}
 
 	return self;
@@ -43,30 +84,53 @@
 
 #pragma mark -
 
-- (CGRect)boundsNotCoveredByKeyboardForView:(UIView *)view {
+- (BOOL)keyboardCanCoverViews {
+	// Well, the keyboard is hidden (or we assume it is) when not visible.
+	return _state == MMMKeyboardStateVisible;
+}
 
-	CGRect bounds = view.bounds;
+/// The target frame of the keyboard in the coordinates of the given window.
+- (CGRect)keyboardFrameInWindow:(nullable UIWindow *)window {
+	if (!window)
+		return _endFrame;
+	// The keyboard frames are in screen coordinates, which are often but not always the same as the window's.
+	return [window convertRect:_endFrame fromCoordinateSpace:window.screen.coordinateSpace];
+}
 
-	if (_state == MMMKeyboardStateUnknown || _state == MMMKeyboardStateHidden) {
-		// Well, the keyboard is hidden (or we assume it is)
-		return bounds;
+/// The height of the part of the given view covered by the keyboard, assuming it can cover views.
+///
+/// The comparison happens in the window's coordinates, so the view needs a single conversion of its own bounds,
+/// while the keyboard frame is converted once per window when the optional table is used to cache it.
+- (CGFloat)coveredHeightForView:(UIView *)view framesByWindow:(nullable NSMapTable<UIWindow *, NSValue *> *)framesByWindow {
+
+	UIWindow *window = view.window;
+
+	CGRect keyboardFrame;
+	NSValue *cached = window ? [framesByWindow objectForKey:window] : nil;
+	if (cached) {
+		keyboardFrame = [cached CGRectValue];
+	} else {
+		keyboardFrame = [self keyboardFrameInWindow:window];
+		if (window)
+			[framesByWindow setObject:[NSValue valueWithCGRect:keyboardFrame] forKey:window];
 	}
 
-	CGRect keyboardFrame = [view convertRect:_endFrame fromView:nil];
-	if (CGRectGetMaxY(bounds) <= CGRectGetMinY(keyboardFrame)) {
-		// The keyboard is far below the view, we have all the bounds
-		return bounds;
-	} else  {
-		// The keyboard is covering the view partially or wholly, let's adjust the height of the bounds not covered
-		bounds.size.height = MAX(CGRectGetMinY(keyboardFrame) - CGRectGetMinY(bounds), 0);
-		return bounds;
-	}
+	return MMMKeyboardCoveredHeight([view convertRect:view.bounds toView:nil], CGRectGetMinY(keyboardFrame));
 }
 
-- (CGFloat)heightOfPartCoveredByKeyboardForView:(UIView *)view {
+- (CGRect)boundsNotCoveredByKeyboardForView:(UIView *)view {
+
 	CGRect bounds = view.bounds;
-	CGRect notCoveredBounds = [self boundsNotCoveredByKeyboardForView:view];
-	return CGRectGetMaxY(bounds) - CGRectGetMaxY(notCoveredBounds);
+	bounds.size.height -= [self heightOfPartCoveredByKeyboardForView:view];
+	return bounds;
+}
+
+- (CGFloat)heightOfPartCoveredByKeyboardForView:(UIView *)view {
+
+	if (![self keyboardCanCoverViews])
+		return 0;
+
+	return [self coveredHeightForView:view framesByWindow:nil];
 }
 
 - (UIEdgeInsets)insetsForBoundsNotCoveredByKeyboardForView:(UIView *)view {
@@ -79,12 +143,22 @@
 
 	NSDictionary *params = [n userInfo];
 
-	_endFrame = [params[UIKeyboardFrameEndUserInfoKey] CGRectValue];
+	CGRect beginFrame = [params[UIKeyboardFrameBeginUserInfoKey] CGRectValue];
+	CGRect endFrame = [params[UIKeyboardFrameEndUserInfoKey] CGRectValue];
 	NSTimeInterval duration = [params[UIKeyboardAnimationDurationUserInfoKey] doubleValue];
 	UIViewAnimationCurve curve = (UIViewAnimationCurve)[params[UIKeyboardAnimationCurveUserInfoKey] integerValue];
 
+	// The same change is typically reported twice: via 'will show/hide' and via 'will change frame' notifications.
+	if (state == _state && CGRectEqualToRect(endFrame, _endFrame))
+		return;
+
+	_endFrame = endFrame;
 	_state = state;
 
+	[self animateFrameFrom:CGRectIsNull(_frame) ? beginFrame : _frame to:endFrame duration:duration curve:curve];
+
+	[self updateLayoutHelpers];
+
 	[_earlyObserverHub forEachObserver:^(id<MMMKeyboardObserver> observer) {
 		[observer keyboard:self willChangeStateWithAnimationDuration:duration curve:curve];
 	}];
@@ -101,6 +175,87 @@
 	[self keyboardWillChange:n state:MMMKeyboardStateHidden];
 }
 
+- (void)keyboardWillChangeFrame:(NSNotification *)n {
+
+	// Sent alone when the keyboard floats, changes its height (e.g. the predictive bar) or is released after
+	// being dragged, so we have to guess the state from the geometry.
+	CGRect endFrame = [[n userInfo][UIKeyboardFrameEndUserInfoKey] CGRectValue];
+	BOOL visible = endFrame.size.height > 0 && CGRectIntersectsRect(endFrame, [UIScreen mainScreen].bounds);
+
+	[self keyboardWillChange:n state:visible ? MMMKeyboardStateVisible : MMMKeyboardStateHidden];
+}
+
+#pragma mark -
+
+- (void)animateFrameFrom:(CGRect)from to:(CGRect)to duration:(NSTimeInterval)duration curve:(UIViewAnimationCurve)curve {
+
+	[_frameAnimation cancel];
+	_frameAnimation = nil;
+
+	if (duration <= 0) {
+		// Some changes come without animation (e.g. undocking the keyboard), just following them.
+		[self setFrame:to];
+		return;
+	}
+
+	MMMAnimationCurve animationCurve = MMMAnimationCurveFromViewAnimationCurve(curve);
+
+	typeof(self) __weak weakSelf = self;
+	_frameAnimation = [[MMMAnimator shared]
+		addAnimationWithDuration:duration
+		updateBlock:^(MMMAnimationHandle *item, CGFloat time) {
+			[weakSelf
+				setFrame:[MMMAnimation
+					rectFrom:from to:to
+					time:[MMMAnimation curvedTimeForTime:time curve:animationCurve]
+				]
+			];
+		}
+		doneBlock:nil
+	];
+}
+
+- (void)setFrame:(CGRect)frame {
+
+	if (CGRectEqualToRect(_frame, frame))
+		return;
+
+	_frame = frame;
+
+	void (^notify)(id<MMMKeyboardObserver>) = ^(id<MMMKeyboardObserver> observer) {
+		if ([observer respondsToSelector:@selector(keyboardDidUpdateFrame:)])
+			[observer keyboardDidUpdateFrame:self];
+	};
+	[_earlyObserverHub forEachObserver:notify];
+	[_observerHub forEachObserver:notify];
+}
+
+#pragma mark -
+
+- (void)addLayoutHelper:(MMMKeyboardLayoutHelper *)helper {
+	[_layoutHelpers addObject:helper];
+}
+
+- (void)updateLayoutHelpers {
+
+	if (![self keyboardCanCoverViews]) {
+		// No need to convert anything, nothing is covered.
+		for (MMMKeyboardLayoutHelper *helper in [_layoutHelpers allObjects]) {
+			[helper setCoveredHeight:0];
+		}
+		return;
+	}
+
+	// The helpers typically share the window, so the keyboard frame is converted once per window,
+	// and then once per helper its view's bounds are.
+	NSMapTable<UIWindow *, NSValue *> *framesByWindow = [NSMapTable weakToStrongObjectsMapTable];
+
+	for (MMMKeyboardLayoutHelper *helper in [_layoutHelpers allObjects]) {
+		UIView *view = [helper view];
+		[helper setCoveredHeight:view ? [self coveredHeightForView:view framesByWindow:framesByWindow] : 0];
+	}
+}
+
 #pragma mark -
 
 - (id<MMMObserverToken>)addObserver:(id<MMMKeyboardObserver>)observer {
@@ -117,11 +272,7 @@
 
 #import <objc/runtime.h>
 
-@interface MMMKeyboardLayoutHelper () <MMMKeyboardObserver>
-@end
-
 @implementation MMMKeyboardLayoutHelper {
-	id<MMMObserverToken> _keyboardObserverToken;
 	NSLayoutConstraint *_heightConstraint;
 }
 
@@ -139,9 +290,6 @@ static char MMMKeyboardLayoutGuideKey[] = "MMMKayboardLayoutGuide";
 
 	if (self = [super init]) {
 
-		// Want to be notified earlier than potential users of our constraints.
-		_keyboardObserverToken = [[MMMKeyboard shared] addEarlyObserver:self];
-
 		_layoutGuide = [[UILayoutGuide alloc] init];
 		_layoutGuide.identifier = @"MMMKeyboardLayoutGuide";
 
@@ -177,21 +325,30 @@ static char MMMKeyboardLayoutGuideKey[] = "MMMKayboardLayoutGuide";
 		]];
 
 		objc_setAssociatedObject(view, MMMKeyboardLayoutGuideKey, self, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+
+		// The keyboard updates all the helpers in one pass earlier than notifying potential users of our constraints.
+		[[MMMKeyboard shared] addLayoutHelper:self];
+
+		// The keyboard might be visible already, it won't be reported again till it changes.
+		[self update];
 	}
 
 	return self;
 }
 
-- (void)update {
-	UIView *view = _layoutGuide.owningView;
-	_heightConstraint.constant = view ? [[MMMKeyboard shared] heightOfPartCoveredByKeyboardForView:view] : 0;
+- (UIView *)view {
+	return _layoutGuide.owningView;
+}
+
+- (void)setCoveredHeight:(CGFloat)height {
+	// Touching the constant invalidates the layout even if it's the same, so checking first.
+	if (_heightConstraint.constant != height)
+		_heightConstraint.constant = height;
 }
 
-- (void)keyboard:(MMMKeyboard *)keyboard
-	willChangeStateWithAnimationDuration:(NSTimeInterval)duration
-	curve:(UIViewAnimationCurve)curve
-{
-	[self update];
+- (void)update {
+	UIView *view = [self view];
+	[self setCoveredHeight:view ? [[MMMKeyboard shared] heightOfPartCoveredByKeyboardForView:view] : 0];
 }
 
 @end
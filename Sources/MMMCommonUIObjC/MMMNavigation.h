@@ -7,6 +7,20 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * A small integer corresponding to an interned action string of a navigation hop.
+ *
+ * The same action string always maps into the same atom within the process, so routing tables and deduplication
+ * of requests can compare and hash integers instead of strings. Zero is never assigned to an action.
+ */
+typedef NSUInteger MMMNavigationAtom;
+
+/** The atom for the given action string, interning the string first if it has not been seen before. */
+extern MMMNavigationAtom MMMNavigationAtomForAction(NSString *action);
+
+/** The action string interned under the given atom or nil if no such atom has been assigned yet. */
+extern NSString * _Nullable MMMNavigationActionForAtom(MMMNavigationAtom atom);
+
 /** 
  * Opening a deep link can involve following through one or more steps, for example:
  *
@@ -22,6 +36,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** Name/ID of the hop. Supposed to be a flat string, like 'recipes', not a path. */
 @property (nonatomic, readonly) NSString *action;
 
+/** The interned version of `action`, see `MMMNavigationAtomForAction()`. */
+@property (nonatomic, readonly) MMMNavigationAtom actionAtom;
+
 /** Optional parameters for this hop only. */
 @property (nonatomic, readonly, nullable) NSDictionary<NSString*, id> *params;
 
@@ -35,6 +52,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 /** 
  * A navigation path is just a collection of one or more "hops".
+ *
+ * Paths (as well as hops) have hashes precomputed on initialization, so they can be used as keys in dictionaries
+ * and sets, e.g. to deduplicate requests. Note that hashes of hops depend only on their actions because a hop
+ * without parameters is considered equal to the hop with the same action and any parameters.
  */
 @interface MMMNavigationPath : NSObject
 
@@ -10,7 +10,64 @@
 //
 //
 //
-@implementation MMMNavigationHop
+
+// Interned actions: the atom of an action is its index in the `actions` array plus one, so zero is never used.
+static NSMutableDictionary<NSString *, NSNumber *> *MMMNavigationAtoms = nil;
+static NSMutableArray<NSString *> *MMMNavigationActions = nil;
+
+static void MMMNavigationAtomsInitIfNeeded(void) {
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		MMMNavigationAtoms = [[NSMutableDictionary alloc] init];
+		MMMNavigationActions = [[NSMutableArray alloc] init];
+	});
+}
+
+static NSString *MMMNavigationInternAction(NSString *action, MMMNavigationAtom *atom) {
+
+	MMMNavigationAtomsInitIfNeeded();
+
+	@synchronized (MMMNavigationActions) {
+
+		NSNumber *existing = MMMNavigationAtoms[action];
+		if (existing) {
+			*atom = [existing unsignedIntegerValue];
+			return MMMNavigationActions[*atom - 1];
+		}
+
+		NSString *interned = [action copy];
+		[MMMNavigationActions addObject:interned];
+		*atom = MMMNavigationActions.count;
+		MMMNavigationAtoms[interned] = @(*atom);
+
+		return interned;
+	}
+}
+
+MMMNavigationAtom MMMNavigationAtomForAction(NSString *action) {
+	MMMNavigationAtom atom;
+	MMMNavigationInternAction(action, &atom);
+	return atom;
+}
+
+NSString *MMMNavigationActionForAtom(MMMNavigationAtom atom) {
+
+	MMMNavigationAtomsInitIfNeeded();
+
+	@synchronized (MMMNavigationActions) {
+		if (atom == 0 || atom > MMMNavigationActions.count)
+			return nil;
+		return MMMNavigationActions[atom - 1];
+	}
+}
+
+//
+//
+//
+@implementation MMMNavigationHop {
+	// Order-independent combination of hashes of the parameters, 0 when there are no parameters.
+	NSUInteger _paramsHash;
+}
 
 - (nonnull id)initWithAction:(NSString *)action {
 	return [self initWithAction:action params:nil];
@@ -18,22 +75,44 @@
 
 - (nonnull id)initWithAction:(NSString *)action params:(NSDictionary *)params {
 	if (self = [super init]) {
-		_action = [action copy];
+
+		_action = MMMNavigationInternAction(action, &_actionAtom);
 		_params = [params copy];
+
+		for (NSString *key in _params) {
+			// Summing and not XORing, so equal key/value hashes do not cancel each other.
+			_paramsHash += [key hash] * 31 + [_params[key] hash];
+		}
 	}
 	return self;
 }
 
+- (NSUInteger)hash {
+	// Parameters cannot participate here because a hop without them matches hops with any parameters (see below).
+	return _actionAtom;
+}
+
 - (BOOL)isEqual:(MMMNavigationHop *)other {
 
+	if (self == other)
+		return YES;
+
 	if (![other isKindOfClass:[MMMNavigationHop class]])
 		return NO;
 
-	if (![self.action isEqual:other.action])
+	// Interned actions, so comparing atoms is enough.
+	if (_actionAtom != other->_actionAtom)
 		return NO;
 
-	if (self.params && ![self.params isEqual:other.params])
-		return NO;
+	if (self.params) {
+
+		// Hashes of equal dictionaries must be equal too, so can avoid a deep comparison in most cases.
+		if (!other->_params || _paramsHash != other->_paramsHash)
+			return NO;
+
+		if (![self.params isEqual:other.params])
+			return NO;
+	}
 
 	return YES;
 }
@@ -47,7 +126,10 @@
 //
 //
 //
-@implementation MMMNavigationPath
+@implementation MMMNavigationPath {
+	// Combined hashes of all the hops, precomputed as the path is immutable.
+	NSUInteger _hash;
+}
 
 - (nonnull id)initWithURI:(NSString *)uri {
 
@@ -64,7 +146,12 @@
 - (nonnull id)initWithHops:(NSArray<MMMNavigationHop *> *)hops {
 
 	if (self = [super init]) {
-		_hops = hops ? hops : @[];
+
+		_hops = hops ? [hops copy] : @[];
+
+		for (MMMNavigationHop *hop in _hops) {
+			_hash = _hash * 31 + [hop hash];
+		}
 	}
 
 	return self;
@@ -115,11 +202,22 @@
 	return [self path];
 }
 
+- (NSUInteger)hash {
+	return _hash;
+}
+
 - (BOOL)isEqual:(MMMNavigationPath *)object {
 
+	if (self == object)
+		return YES;
+
 	if (![object isKindOfClass:self.class])
 		return NO;
 
+	// Cheap checks first: paths having different hashes or number of hops cannot be equal.
+	if (_hash != object->_hash || _hops.count != object->_hops.count)
+		return NO;
+
 	if (![self.hops isEqual:object.hops])
 		return NO;
 
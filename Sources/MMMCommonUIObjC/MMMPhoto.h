@@ -49,6 +49,11 @@ typedef NS_ENUM(NSInteger, MMMPhotoContentMode) {
 
 /**
  * A regular UIImage wrapped into the WIGPhoto interface, can be handy for tests.
+ *
+ * Target sizes are treated as pixels (like in `MMMPhotoFromLibrary`): images requested for sizes smaller than
+ * the original are downsampled in the background (see `MMMImageDecoder`) and kept in `MMMDecodedImageCache`,
+ * so a thumbnail grid does not keep the full bitmap around per cell. The loadables are reused while they are
+ * in use by someone.
  */
 @interface MMMPhotoFromUIImage : NSObject <MMMPhoto>
 
@@ -58,12 +63,15 @@ typedef NS_ENUM(NSInteger, MMMPhotoContentMode) {
 @end
 
 /**
- * Another implementation of WIGPhoto handy for tests: the images are downloaded from a web service hosting
- * placeholder images.
+ * Another implementation of WIGPhoto handy for tests: the images are generated locally by `MMMPlaceholderImageLoader`,
+ * so tests and benchmarks do not depend on the network.
+ *
+ * The images are generated at exactly the target size, so the content mode passed to `imageForTargetSize:contentMode:`
+ * is ignored.
  */
 @interface WIGTestPlaceholderPhoto : NSObject <MMMPhoto>
 
-/** The index influences which image will be fetched, i.e. items with the same indexes should have the same picture. */
+/** The index influences which image will be generated, i.e. items with the same indexes should have the same picture. */
 - (instancetype)initWithIndex:(NSInteger)index NS_DESIGNATED_INITIALIZER;
 
 - (instancetype)init NS_UNAVAILABLE;
@@ -5,7 +5,11 @@
 
 #import "MMMPhoto.h"
 
+#import "MMMDecodedImageCache.h"
+#import "MMMImageDecoder.h"
+#import "MMMLoadable+Subclasses.h"
 #import "MMMPhotoLibraryLoadableImage.h"
+#import "MMMPlaceholderImage.h"
 @import Photos;
 
 //
@@ -46,17 +50,128 @@
 //
 //
 //
+
+/// A downsampled version of the image of `MMMPhotoFromUIImage`.
+@interface MMMPhotoFromUIImageVariant : MMMLoadable <MMMLoadableImage, MMMDecodedImageCacheSource>
+
+- (id)initWithSourceImage:(UIImage *)sourceImage
+	key:(MMMDecodedImageCacheKey *)key
+	contentMode:(MMMImageDecoderContentMode)contentMode NS_DESIGNATED_INITIALIZER;
+
+- (id)init NS_UNAVAILABLE;
+
+@end
+
+@implementation MMMPhotoFromUIImageVariant {
+	UIImage *_sourceImage;
+	MMMImageDecoderContentMode _contentMode;
+	MMMImageDecoderRequest *_request;
+	// How many times the decoder has returned the source image as is because it was too busy.
+	NSInteger _numberOfSkippedDecodes;
+}
+
+@synthesize image = _image;
+@synthesize decodedImageCacheKey = _decodedImageCacheKey;
+
+- (id)initWithSourceImage:(UIImage *)sourceImage
+	key:(MMMDecodedImageCacheKey *)key
+	contentMode:(MMMImageDecoderContentMode)contentMode
+{
+	if (self = [super init]) {
+		_sourceImage = sourceImage;
+		_decodedImageCacheKey = key;
+		_contentMode = contentMode;
+	}
+	return self;
+}
+
+- (void)dealloc {
+	[_request cancel];
+}
+
+- (BOOL)isContentsAvailable {
+	return _image != nil;
+}
+
+- (void)doSync {
+
+	UIImage *cachedImage = [[MMMDecodedImageCache shared] imageForKey:_decodedImageCacheKey];
+	if (cachedImage) {
+		_image = cachedImage;
+		[self setDidSyncSuccessfully];
+		return;
+	}
+
+	_numberOfSkippedDecodes = 0;
+	[self startDecoding];
+}
+
+- (void)startDecoding {
+
+	[_request cancel];
+	typeof(self) __weak weakSelf = self;
+	_request = [[MMMImageDecoder shared]
+		decodeImage:_sourceImage
+		pixelSize:_decodedImageCacheKey.pixelSize
+		contentMode:_contentMode
+		completion:^(UIImage *image) {
+			[weakSelf didDecodeImage:image];
+		}
+	];
+}
+
+/// The max number of times the decoding is retried after the decoder skips it under back-pressure.
+static NSInteger const MMMPhotoFromUIImageVariantMaxRetries = 3;
+
+- (void)didDecodeImage:(UIImage *)image {
+
+	_request = nil;
+
+	if (image == _sourceImage) {
+
+		// The decoder was too busy and returned the source as is. It can be shown for now, but should not be cached
+		// under the key of this (smaller) variant; trying again a bit later instead.
+		_image = image;
+
+		if (_numberOfSkippedDecodes < MMMPhotoFromUIImageVariantMaxRetries) {
+			_numberOfSkippedDecodes++;
+			[self notifyDidChange];
+			typeof(self) __weak weakSelf = self;
+			dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.25 * _numberOfSkippedDecodes * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+				typeof(self) strongSelf = weakSelf;
+				if (strongSelf && strongSelf.loadableState == MMMLoadableStateSyncing) {
+					[strongSelf startDecoding];
+				}
+			});
+		} else {
+			// Not syncing forever, the full image is going to be displayed then.
+			[self setDidSyncSuccessfully];
+		}
+		return;
+	}
+
+	_image = image;
+	[[MMMDecodedImageCache shared] setImage:image forKey:_decodedImageCacheKey];
+	[self setDidSyncSuccessfully];
+}
+
+@end
+
 @implementation MMMPhotoFromUIImage {
 	MMMImmediateLoadableImage *_loadable;
 	UIImage *_image;
+	// Identifies our image in the shared cache.
+	NSString *_sourceIdentifier;
+	// Variants that are still in use by somebody, by their cache keys.
+	NSMapTable<MMMDecodedImageCacheKey *, MMMPhotoFromUIImageVariant *> *_variants;
 }
 
 - (id)initWithImage:(UIImage *)image {
 
 	if (self = [super init]) {
-
-		// TODO: downscale it to the size that makes sense asap, then get rid of the original
 		_image = image;
+		_sourceIdentifier = [NSString stringWithFormat:@"MMMPhotoFromUIImage:%@", [NSUUID UUID].UUIDString];
+		_variants = [NSMapTable strongToWeakObjectsMapTable];
 	}
 
 	return self;
@@ -64,12 +179,34 @@
 
 - (id<MMMLoadableImage>)imageForTargetSize:(CGSize)targetSize contentMode:(MMMPhotoContentMode)contentMode {
 
-	// TODO: For now we don't trim it for different target sizes, but maybe we should downscale when a thumbnail is requested.
-	if (!_loadable) {
-		_loadable = [[MMMImmediateLoadableImage alloc] initWithImage:_image];
+	CGSize pixelSize = CGSizeMake(_image.size.width * _image.scale, _image.size.height * _image.scale);
+	MMMImageDecoderContentMode decoderContentMode = (contentMode == MMMPhotoContentModeAspectFill)
+		? MMMImageDecoderContentModeFill
+		: MMMImageDecoderContentModeFit;
+
+	// No need in a variant when the image is small enough already (or when the size is unknown).
+	CGFloat fx = targetSize.width / pixelSize.width;
+	CGFloat fy = targetSize.height / pixelSize.height;
+	CGFloat factor = (decoderContentMode == MMMImageDecoderContentModeFill) ? MAX(fx, fy) : MIN(fx, fy);
+	if (!(factor > 0 && factor < 1)) {
+		if (!_loadable) {
+			_loadable = [[MMMImmediateLoadableImage alloc] initWithImage:_image];
+		}
+		return _loadable;
 	}
 
-	return _loadable;
+	MMMDecodedImageCacheKey *key = [[MMMDecodedImageCacheKey alloc]
+		initWithSourceIdentifier:_sourceIdentifier
+		pixelSize:targetSize
+		contentMode:decoderContentMode
+	];
+	MMMPhotoFromUIImageVariant *variant = [_variants objectForKey:key];
+	if (!variant) {
+		variant = [[MMMPhotoFromUIImageVariant alloc] initWithSourceImage:_image key:key contentMode:decoderContentMode];
+		[_variants setObject:variant forKey:key];
+	}
+
+	return variant;
 }
 
 @end
@@ -91,8 +228,11 @@
 }
 
 - (id<MMMLoadableImage>)imageForTargetSize:(CGSize)targetSize contentMode:(MMMPhotoContentMode)contentMode {
-	NSString *url = [NSString stringWithFormat:@"https://loremflickr.com/%li/%li?lock=%li", (long)targetSize.width, (long)targetSize.height, (long)_index];
-	return [[MMMPublicLoadableImage alloc] initWithURL:[NSURL URLWithString:url]];
+	return [[MMMPlaceholderLoadableImage alloc]
+		initWithIndex:_index
+		pixelSize:targetSize
+		loader:[MMMPlaceholderImageLoader shared]
+	];
 }
 
 @end
@@ -6,6 +6,9 @@
 @import MMMLoadable;
 @import Photos;
 
+#import "MMMDecodedImageCache.h"
+#import "MMMImageRequestCoalescer.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 /**
@@ -14,8 +17,11 @@ NS_ASSUME_NONNULL_BEGIN
  *
  * Note that this implementation is not suitable for the case when you need a lots of small thumbnails.
  * It's better to user the Photos framework directly in this case. This is more suitable for fetching a bunch of larger images.
+ *
+ * The images are shared via `MMMDecodedImageCache`, so another instance pointing to the same asset with the same
+ * target size and content mode syncs right away without asking the Photo Library again.
  */
-@interface MMMPhotoLibraryLoadableImage : MMMLoadable <MMMLoadableImage>
+@interface MMMPhotoLibraryLoadableImage : MMMLoadable <MMMLoadableImage, MMMDecodedImageCacheSource>
 
 /** The identifier of the the PHAsset which is used to find it in the Photo Library. */
 @property (nonatomic, readonly) NSString *localIdentifier;
@@ -25,12 +31,31 @@ NS_ASSUME_NONNULL_BEGIN
  * though the actual size of the image can be larger. */
 @property (nonatomic, readonly) CGSize targetSize;
 
+/**
+ * YES, if a fast low quality version of the image should be published first (while the loadable is still syncing)
+ * and then upgraded in place with the final one. Passed on initialization, NO by default.
+ *
+ * The low quality version is dropped if the final one fails to load, i.e. a failed image has no contents.
+ */
+@property (nonatomic, readonly, getter=isProgressive) BOOL progressive;
+
 - (id)initWithLocalIdentifier:(NSString *)localIdentifier
 	targetSize:(CGSize)targetSize
-	contentMode:(PHImageContentMode)contentMode NS_DESIGNATED_INITIALIZER;
+	contentMode:(PHImageContentMode)contentMode
+	progressive:(BOOL)progressive NS_DESIGNATED_INITIALIZER;
+
+- (id)initWithLocalIdentifier:(NSString *)localIdentifier
+	targetSize:(CGSize)targetSize
+	contentMode:(PHImageContentMode)contentMode;
 
 - (id)init NS_UNAVAILABLE;
 
+/**
+ * The coalescer all the instances request their images from, so identical requests are joined.
+ * Subclasses can override it to load the images from somewhere else.
+ */
++ (MMMImageRequestCoalescer *)requestCoalescer;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -5,9 +5,147 @@
 
 #import "MMMPhotoLibraryLoadableImage.h"
 
+#import "MMMImageRequestCoalescer.h"
 #import "MMMLoadable+Subclasses.h"
 @import MMMCommonCore;
 
+/// A request made via `MMMPhotoLibraryImageRequestPerformer`; accessed only on the queue of the performer.
+@interface MMMPhotoLibraryImageRequest : NSObject {
+	@public
+	PHImageRequestID _requestID;
+	// YES, if _requestID is valid (because there is no official invalid value for PHImageRequestID documented).
+	BOOL _requestIDValid;
+	BOOL _cancelled;
+}
+@end
+
+@implementation MMMPhotoLibraryImageRequest
+@end
+
+/// Fetches assets and requests their images on a dedicated serial queue, so the access to the Photo Library
+/// does not block the main thread and does not occupy more than one thread of the global queues.
+@interface MMMPhotoLibraryImageRequestPerformer : NSObject <MMMImageRequestPerformer>
+@end
+
+@implementation MMMPhotoLibraryImageRequestPerformer {
+	dispatch_queue_t _queue;
+	PHImageManager *_imageManager;
+}
+
+- (id)init {
+	if (self = [super init]) {
+		_queue = dispatch_queue_create("MMMPhotoLibraryLoadableImage", DISPATCH_QUEUE_SERIAL);
+		_imageManager = [PHImageManager defaultManager];
+	}
+	return self;
+}
+
+- (NSError *)errorWithMessage:(NSString *)message {
+	return [NSError mmm_errorWithDomain:NSStringFromClass([MMMPhotoLibraryLoadableImage class]) message:message];
+}
+
+- (id)startImageRequestForKey:(MMMDecodedImageCacheKey *)key
+	progress:(MMMImageRequestProgress)progress
+	completion:(MMMImageRequestCompletion)completion
+{
+
+	MMMPhotoLibraryImageRequest *request = [[MMMPhotoLibraryImageRequest alloc] init];
+
+	dispatch_async(_queue, ^{
+
+		if (request->_cancelled)
+			return;
+
+		PHFetchResult<PHAsset *> *result = [PHAsset fetchAssetsWithLocalIdentifiers:@[ key.sourceIdentifier ] options:nil];
+
+		PHAsset *asset = result.firstObject;
+		if (!asset) {
+			completion(nil, [self
+				errorWithMessage:[NSString stringWithFormat:@"Could not fetch the asset #%@", key.sourceIdentifier]
+			]);
+			return;
+		}
+
+		PHImageRequestOptions *options = [[PHImageRequestOptions alloc] init];
+
+		// We want the latest version of the image with all the edits, etc.
+		// This is probably the default option, but it's not mentioned in the docs, so let's be explicit.
+		options.version = PHImageRequestOptionsVersionCurrent;
+
+		// We want the best quality image. Getting several calls is interesting only when somebody wants to display
+		// something quickly, otherwise this class is not designed to present a lot of images fast.
+		options.deliveryMode = progress
+			? PHImageRequestOptionsDeliveryModeOpportunistic
+			: PHImageRequestOptionsDeliveryModeHighQualityFormat;
+
+		// Photos can call us several times in the opportunistic mode, including after an error.
+		// Accessed only within the result handler, which is called serially.
+		MMMProgressiveImageDelivery *delivery = [[MMMProgressiveImageDelivery alloc] init];
+
+		// We are OK to get something larger than we want.
+		options.resizeMode = PHImageRequestOptionsResizeModeFast;
+
+		request->_requestID = [self->_imageManager
+			requestImageForAsset:asset
+			targetSize:key.pixelSize
+			contentMode:(PHImageContentMode)key.contentMode
+			options:options
+			resultHandler:^(UIImage * _Nullable result, NSDictionary * _Nullable info) {
+
+				if ([info[PHImageCancelledKey] boolValue])
+					return;
+
+				BOOL degraded = [info[PHImageResultIsDegradedKey] boolValue];
+				switch ([delivery actionForImage:result degraded:degraded]) {
+					case MMMProgressiveImageDeliveryActionIgnore:
+						return;
+					case MMMProgressiveImageDeliveryActionProgress:
+						if (progress)
+							progress(result);
+						return;
+					case MMMProgressiveImageDeliveryActionComplete:
+						break;
+				}
+
+				[[MMMNetworkConditioner shared]
+					conditionBlock:^(NSError *error) {
+						if (error) {
+							completion(nil, error);
+						} else if (result) {
+							completion(result, nil);
+						} else {
+							completion(nil, info[PHImageErrorKey] ?: [self
+								errorWithMessage:[NSString
+									stringWithFormat:@"Could not fetch the image for target size %@",
+									NSStringFromCGSize(key.pixelSize)
+								]
+							]);
+						}
+					}
+					inContext:NSStringFromClass([MMMPhotoLibraryLoadableImage class])
+					estimatedResponseLength:0
+				];
+			}
+		];
+		request->_requestIDValid = YES;
+	});
+
+	return request;
+}
+
+- (void)cancelImageRequest:(id)request {
+	MMMPhotoLibraryImageRequest *r = request;
+	dispatch_async(_queue, ^{
+		r->_cancelled = YES;
+		if (r->_requestIDValid) {
+			[self->_imageManager cancelImageRequest:r->_requestID];
+			r->_requestIDValid = NO;
+		}
+	});
+}
+
+@end
+
 //
 //
 //
@@ -15,115 +153,118 @@
 
 	PHImageContentMode _contentMode;
 
-	PHImageManager *_imageManager;
-
-	PHImageRequestID _requestID;
-
-	// YES, if _requestID is valid (because there is no official invalid value for PHImageRequestID documented).
-	BOOL _requestIDValid;
+	MMMImageRequestSubscription *_subscription;
 }
 
 @synthesize image = _image;
 
++ (MMMImageRequestCoalescer *)requestCoalescer {
+	static MMMImageRequestCoalescer *coalescer = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		coalescer = [[MMMImageRequestCoalescer alloc]
+			initWithPerformer:[[MMMPhotoLibraryImageRequestPerformer alloc] init]
+			maxConcurrentRequests:4
+		];
+	});
+	return coalescer;
+}
+
 - (id)initWithLocalIdentifier:(NSString *)localIdentifier
 	targetSize:(CGSize)targetSize
 	contentMode:(PHImageContentMode)contentMode
+	progressive:(BOOL)progressive
 {
 	if (self = [super init]) {
 		_localIdentifier = localIdentifier;
 		_targetSize = targetSize;
 		_contentMode = contentMode;
-		_imageManager = [PHImageManager defaultManager];
+		_progressive = progressive;
 	}
 
 	return self;
 }
 
-- (BOOL)isContentsAvailable {
-	return _image != nil;
-}
-
-- (NSError *)errorWithMessage:(NSString *)message {
-	return [NSError mmm_errorWithDomain:NSStringFromClass(self.class) message:message];
+- (id)initWithLocalIdentifier:(NSString *)localIdentifier
+	targetSize:(CGSize)targetSize
+	contentMode:(PHImageContentMode)contentMode
+{
+	return [self initWithLocalIdentifier:localIdentifier targetSize:targetSize contentMode:contentMode progressive:NO];
 }
 
-- (void)doSyncDeferred {
-
-	PHFetchResult<PHAsset *> *result = [PHAsset fetchAssetsWithLocalIdentifiers:@[ _localIdentifier ] options:nil];
-
-	PHAsset *asset = result.firstObject;
-	if (!asset) {
-		[self setFailedToSyncWithError:[self
-			errorWithMessage:[NSString stringWithFormat:@"Could not fetch the asset #%@", _localIdentifier]
-		]];
+- (void)dealloc {
+	// The actual request is cancelled if nobody else needs the same image. The coalescer is main thread only,
+	// while the last reference to us can go away anywhere, e.g. in a background completion block.
+	MMMImageRequestSubscription *subscription = _subscription;
+	if (!subscription)
 		return;
+	if ([NSThread isMainThread]) {
+		[subscription cancel];
+	} else {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[subscription cancel];
+		});
 	}
+}
 
-	PHImageRequestOptions *options = [[PHImageRequestOptions alloc] init];
-
-	// We want the latest version of the image with all the edits, etc.
-	// This is probably the default option, but it's not mentioned in the docs, so let's be explicit.
-	options.version = PHImageRequestOptionsVersionCurrent;
-
-	// We want the best quality image, getting several calls is not interesting as this class
-	// is not designed to present a lot of images quickly, Photos should be used directly in this case.
-	options.deliveryMode = PHImageRequestOptionsDeliveryModeHighQualityFormat;
-
-	// We are OK to get something larger than we want.
-	options.resizeMode = PHImageRequestOptionsResizeModeFast;
-
-	typeof(self) __weak weakSelf = self;
-	_requestID = [_imageManager
-		requestImageForAsset:asset
-		targetSize:_targetSize
+- (MMMDecodedImageCacheKey *)decodedImageCacheKey {
+	return [[MMMDecodedImageCacheKey alloc]
+		initWithSourceIdentifier:_localIdentifier
+		// Photos treats the target size as pixels already.
+		pixelSize:_targetSize
 		contentMode:_contentMode
-		options:options
-		resultHandler:^(UIImage * _Nullable result, NSDictionary * _Nullable info) {
-			[[MMMNetworkConditioner shared]
-				conditionBlock:^(NSError *error) {
-					dispatch_async(dispatch_get_main_queue(), ^{
-						typeof(self) strongSelf = weakSelf;
-						if (error) {
-							[strongSelf didFinishRequestWithError:error image:nil info:nil];
-						} else {
-							[strongSelf didFinishRequestWithError:nil image:result info:info];
-						}
-					});
-				}
-				inContext:NSStringFromClass(self.class)
-				estimatedResponseLength:0
-			];
-		}
 	];
-	_requestIDValid = YES;
 }
 
-- (void)didFinishRequestWithError:(NSError *)error image:(UIImage *)image info:(NSDictionary *)info {
+- (BOOL)isContentsAvailable {
+	return _image != nil;
+}
+
+- (void)didReceiveIntermediateImage:(UIImage *)image {
+	// Still syncing, but there is something to show already.
+	_image = image;
+	[self notifyDidChange];
+}
+
+- (void)didFinishRequestWithError:(NSError *)error image:(UIImage *)image {
+
+	_subscription = nil;
 
 	if (image) {
 		_image = image;
+		[[MMMDecodedImageCache shared] setImage:image forKey:self.decodedImageCacheKey];
 		[self setDidSyncSuccessfully];
 	} else {
-		[self setFailedToSyncWithError:error ?: [self
-			errorWithMessage:[NSString
-				stringWithFormat:@"Could not fetch the image for target size %@",
-				NSStringFromCGSize(_targetSize)
-			]
-		]];
+		// A preview of a failed image is not its contents.
+		_image = nil;
+		[self setFailedToSyncWithError:error];
 	}
 }
 
 - (void)doSync {
 
-	// Let's offload this to a queue just in case the access to fetchAssetsWithLocalIdentifiers: is slow.
+	MMMDecodedImageCacheKey *key = self.decodedImageCacheKey;
+
+	// Somebody might have loaded the same image already.
+	UIImage *cachedImage = [[MMMDecodedImageCache shared] imageForKey:key];
+	if (cachedImage) {
+		_image = cachedImage;
+		[self setDidSyncSuccessfully];
+		return;
+	}
+
+	// Identical requests made by other instances are joined.
+	[_subscription cancel];
 	typeof(self) __weak weakSelf = self;
-	dispatch_async(
-		dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
-		^{
-			typeof(self) strongSelf = weakSelf;
-			[strongSelf doSyncDeferred];
+	_subscription = [[[self class] requestCoalescer]
+		requestImageForKey:key
+		progress:!_progressive ? nil : ^(UIImage *image) {
+			[weakSelf didReceiveIntermediateImage:image];
+		}
+		completion:^(UIImage *image, NSError *error) {
+			[weakSelf didFinishRequestWithError:error image:image];
 		}
-	);
+	];
 }
 
 @end
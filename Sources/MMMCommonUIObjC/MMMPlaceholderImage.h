@@ -0,0 +1,75 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+@import UIKit;
+@import MMMLoadable;
+
+#import "MMMDecodedImageCache.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A procedurally generated picture for tests and benchmarks: a diagonal gradient in colors derived from the index,
+ * some noise (so the image compresses like a photo rather than like a flat fill) and the index itself in the middle.
+ *
+ * The same index and size always produce the same pixels. The scale of the image is 1, i.e. the size is in pixels.
+ * Can be called from any thread.
+ */
+extern UIImage *MMMPlaceholderImageWithIndex(NSInteger index, CGSize pixelSize);
+
+typedef void (^MMMPlaceholderImageLoaderCompletion)(UIImage *image);
+
+/**
+ * A local stand-in for a web service hosting placeholder images, so tests and benchmarks of the image pipeline
+ * (caches, decoding, prefetching) are reproducible and work offline.
+ *
+ * The images are generated via `MMMPlaceholderImageWithIndex()` and encoded as PNG, as if they were downloaded,
+ * then "transferred" with the configured latency and bandwidth and decoded back like a response would be.
+ */
+@interface MMMPlaceholderImageLoader : NSObject
+
+/** The loader used by `WIGTestPlaceholderPhoto`. */
++ (instancetype)shared;
+
+/** The time before the first byte of every response arrives. 0.3 seconds by default. */
+@property (atomic) NSTimeInterval latency;
+
+/** Bytes per second for every response or 0 for unlimited. 1MB/s by default. */
+@property (atomic) double bandwidth;
+
+/** Loads the image with the given index and size, calling the completion on the main queue. */
+- (void)loadImageWithIndex:(NSInteger)index
+	pixelSize:(CGSize)pixelSize
+	completion:(MMMPlaceholderImageLoaderCompletion)completion
+	NS_SWIFT_NAME(loadImage(index:pixelSize:completion:));
+
+/** The number of images requested so far. For diagnostics only. */
+@property (atomic, readonly) NSInteger numberOfRequests;
+
+/** The number of (encoded) bytes "transferred" so far. For diagnostics only. */
+@property (atomic, readonly) NSInteger numberOfTransferredBytes;
+
+@end
+
+/**
+ * A loadable image served by `MMMPlaceholderImageLoader`.
+ *
+ * The image is generated at exactly `pixelSize`, so there is no content mode: it fits and fills at the same time
+ * and all the requests of the same index and size share an entry in `MMMDecodedImageCache`.
+ */
+@interface MMMPlaceholderLoadableImage : MMMLoadable <MMMLoadableImage, MMMDecodedImageCacheSource>
+
+@property (nonatomic, readonly) NSInteger index;
+@property (nonatomic, readonly) CGSize pixelSize;
+
+- (id)initWithIndex:(NSInteger)index
+	pixelSize:(CGSize)pixelSize
+	loader:(MMMPlaceholderImageLoader *)loader NS_DESIGNATED_INITIALIZER;
+
+- (id)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
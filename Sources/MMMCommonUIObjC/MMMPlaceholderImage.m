@@ -0,0 +1,237 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+#import "MMMPlaceholderImage.h"
+
+#import "MMMGradientRasterizer.h"
+#import "MMMImageDecoder.h"
+#import "MMMLoadable+Subclasses.h"
+
+static inline uint64_t MMMPlaceholderImageHash(uint64_t x) {
+	// The finalizer of SplitMix64.
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+static simd_float4 MMMPlaceholderImageColor(float hue, float saturation, float brightness) {
+	// HSB to RGB, hue within [0; 1).
+	float h = (hue - floorf(hue)) * 6;
+	float f = h - floorf(h);
+	float p = brightness * (1 - saturation);
+	float q = brightness * (1 - saturation * f);
+	float t = brightness * (1 - saturation * (1 - f));
+	switch ((int)h % 6) {
+		case 0: return simd_make_float4(brightness, t, p, 1);
+		case 1: return simd_make_float4(q, brightness, p, 1);
+		case 2: return simd_make_float4(p, brightness, t, 1);
+		case 3: return simd_make_float4(p, q, brightness, 1);
+		case 4: return simd_make_float4(t, p, brightness, 1);
+		default: return simd_make_float4(brightness, p, q, 1);
+	}
+}
+
+UIImage *MMMPlaceholderImageWithIndex(NSInteger index, CGSize pixelSize) {
+
+	NSInteger width = MAX(1, (NSInteger)round(pixelSize.width));
+	NSInteger height = MAX(1, (NSInteger)round(pixelSize.height));
+	NSInteger bytesPerRow = width * 4;
+
+	uint64_t hash = MMMPlaceholderImageHash((uint64_t)index);
+
+	// Two neighbouring hues, so the pictures are easy to tell apart but are not too wild.
+	float hue = (float)(hash & 0xFFFF) / 0x10000;
+	simd_float4 from = MMMPlaceholderImageColor(hue, 0.55f, 0.9f);
+	simd_float4 to = MMMPlaceholderImageColor(hue + 0.12f, 0.7f, 0.55f);
+
+	const NSInteger rampCount = 32;
+	simd_float4 ramp[rampCount];
+	MMMGradientRampFill(ramp, rampCount, from, to, MMMAnimationCurveEaseInOut);
+
+	NSMutableData *data = [NSMutableData dataWithLength:bytesPerRow * height];
+	uint8_t *pixels = data.mutableBytes;
+	MMMGradientRasterizeLinear(
+		pixels, width, height, bytesPerRow,
+		ramp, rampCount,
+		simd_make_float2(0, 0), simd_make_float2(width, height)
+	);
+
+	// Luminance noise from a xorshift generator seeded by the index. The alpha is always 1,
+	// so premultiplied values can be changed directly.
+	uint32_t state = (uint32_t)(hash >> 32) | 1;
+	for (NSInteger y = 0; y < height; y++) {
+		uint8_t *p = pixels + y * bytesPerRow;
+		for (NSInteger x = 0; x < width; x++, p += 4) {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			int noise = (int)(state & 15) - 8;
+			for (NSInteger c = 0; c < 3; c++) {
+				p[c] = (uint8_t)MAX(0, MIN(255, (int)p[c] + noise));
+			}
+		}
+	}
+
+	// The index on top via Core Graphics, drawing right into the same pixels.
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+	CGContextRef context = CGBitmapContextCreate(
+		pixels, width, height, 8, bytesPerRow, colorSpace,
+		kCGBitmapByteOrderDefault | kCGImageAlphaPremultipliedLast
+	);
+	CGColorSpaceRelease(colorSpace);
+	if (context) {
+
+		// UIKit's coordinate system.
+		CGContextTranslateCTM(context, 0, height);
+		CGContextScaleCTM(context, 1, -1);
+		UIGraphicsPushContext(context);
+
+		NSString *text = [NSString stringWithFormat:@"%ld", (long)index];
+		NSDictionary *attributes = @{
+			NSFontAttributeName: [UIFont boldSystemFontOfSize:MAX(8, MIN(width, height) * 0.3)],
+			NSForegroundColorAttributeName: [UIColor colorWithWhite:1 alpha:0.85]
+		};
+		CGSize textSize = [text sizeWithAttributes:attributes];
+		[text drawAtPoint:CGPointMake((width - textSize.width) / 2, (height - textSize.height) / 2) withAttributes:attributes];
+
+		UIGraphicsPopContext();
+		CGContextRelease(context);
+	}
+
+	CGImageRef cgImage = MMMCreateImageWithPremultipliedRGBA(data, width, height, bytesPerRow);
+	UIImage *result = [UIImage imageWithCGImage:cgImage scale:1 orientation:UIImageOrientationUp];
+	CGImageRelease(cgImage);
+
+	return result;
+}
+
+//
+//
+//
+@implementation MMMPlaceholderImageLoader {
+	dispatch_queue_t _queue;
+}
+
+@synthesize numberOfRequests = _numberOfRequests;
+@synthesize numberOfTransferredBytes = _numberOfTransferredBytes;
+
++ (instancetype)shared {
+	static MMMPlaceholderImageLoader *shared = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		shared = [[MMMPlaceholderImageLoader alloc] init];
+	});
+	return shared;
+}
+
+- (id)init {
+	if (self = [super init]) {
+		_latency = 0.3;
+		_bandwidth = 1 << 20;
+		_queue = dispatch_queue_create(
+			"MMMPlaceholderImageLoader",
+			dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_CONCURRENT, QOS_CLASS_UTILITY, 0)
+		);
+	}
+	return self;
+}
+
+- (void)loadImageWithIndex:(NSInteger)index pixelSize:(CGSize)pixelSize completion:(MMMPlaceholderImageLoaderCompletion)completion {
+
+	@synchronized (self) {
+		_numberOfRequests++;
+	}
+
+	NSTimeInterval latency = self.latency;
+	double bandwidth = self.bandwidth;
+
+	dispatch_async(_queue, ^{
+
+		// As if it was produced by the server.
+		NSData *data = UIImagePNGRepresentation(MMMPlaceholderImageWithIndex(index, pixelSize));
+
+		@synchronized (self) {
+			self->_numberOfTransferredBytes += data.length;
+		}
+
+		NSTimeInterval delay = latency + (bandwidth > 0 ? data.length / bandwidth : 0);
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), self->_queue, ^{
+			// Decoded lazily as any downloaded image would be.
+			UIImage *image = [UIImage imageWithData:data scale:1];
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completion(image);
+			});
+		});
+	});
+}
+
+- (NSInteger)numberOfRequests {
+	@synchronized (self) {
+		return _numberOfRequests;
+	}
+}
+
+- (NSInteger)numberOfTransferredBytes {
+	@synchronized (self) {
+		return _numberOfTransferredBytes;
+	}
+}
+
+@end
+
+//
+//
+//
+@implementation MMMPlaceholderLoadableImage {
+	MMMPlaceholderImageLoader *_loader;
+}
+
+@synthesize image = _image;
+
+- (id)initWithIndex:(NSInteger)index pixelSize:(CGSize)pixelSize loader:(MMMPlaceholderImageLoader *)loader {
+	if (self = [super init]) {
+		_index = index;
+		_pixelSize = pixelSize;
+		_loader = loader;
+	}
+	return self;
+}
+
+- (MMMDecodedImageCacheKey *)decodedImageCacheKey {
+	return [[MMMDecodedImageCacheKey alloc]
+		initWithSourceIdentifier:[NSString stringWithFormat:@"MMMPlaceholderImage:%ld", (long)_index]
+		pixelSize:_pixelSize
+		// Always generated at exactly the requested size, so it fits and fills it at the same time.
+		contentMode:MMMImageDecoderContentModeFit
+	];
+}
+
+- (BOOL)isContentsAvailable {
+	return _image != nil;
+}
+
+- (void)doSync {
+
+	UIImage *cachedImage = [[MMMDecodedImageCache shared] imageForKey:self.decodedImageCacheKey];
+	if (cachedImage) {
+		_image = cachedImage;
+		[self setDidSyncSuccessfully];
+		return;
+	}
+
+	typeof(self) __weak weakSelf = self;
+	[_loader loadImageWithIndex:_index pixelSize:_pixelSize completion:^(UIImage *image) {
+		[weakSelf didLoadImage:image];
+	}];
+}
+
+- (void)didLoadImage:(UIImage *)image {
+	_image = image;
+	[[MMMDecodedImageCache shared] setImage:image forKey:self.decodedImageCacheKey];
+	[self setDidSyncSuccessfully];
+}
+
+@end
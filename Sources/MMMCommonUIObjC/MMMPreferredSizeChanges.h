@@ -13,11 +13,18 @@ NS_ASSUME_NONNULL_BEGIN
 /// This is handy with views that do not fully rely on Auto Layout, like UITableView,
 /// where a change in the size of a cell would require it to reload this cell.
 ///
-/// The implementation is responsible for coalescing notification and avoiding notification loops.
+/// Notifications are delivered on the main thread before the next layout pass at most once per subview,
+/// but the implementation is still responsible for avoiding notification loops.
 @protocol MMMPreferredSizeChanges <NSObject>
 
 - (void)mmm_preferredSizeCouldChangeForSubview:(UIView *)subview;
 
+@optional
+
+/// When implemented, then it is called instead of `mmm_preferredSizeCouldChangeForSubview:` with all the subviews
+/// that have indicated potential size changes since the previous delivery.
+- (void)mmm_preferredSizeCouldChangeForSubviews:(NSArray<UIView *> *)subviews;
+
 @end
 
 @interface UIView (MMMPreferredSizeChanges)
@@ -26,8 +33,15 @@ NS_ASSUME_NONNULL_BEGIN
 /// that the size of this view could have potentially changed and they should measure things again.
 ///
 /// This helps with containers that do not primarily rely on Auto Layout, like UITableView.
+///
+/// The calls are recorded and delivered to the nearest interested parent in one go before the next layout pass,
+/// so many subviews changing at the same time result in a single notification per parent.
 - (void)mmm_setPreferredSizeCouldChange;
 
+/// Delivers the notifications recorded by `mmm_setPreferredSizeCouldChange` right away instead of waiting for
+/// the end of the current run loop iteration. Handy in unit tests.
++ (void)mmm_deliverPreferredSizeChanges;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -5,16 +5,44 @@
 
 #import "MMMPreferredSizeChanges.h"
 
+/// Interested parents and the subviews that have notified them since the last delivery.
+static NSMapTable<UIView *, NSMutableOrderedSet<UIView *> *> *MMMPreferredSizePending = nil;
+
 @implementation UIView (MMMPreferredSizeCouldChange)
 
-- (void)mmm_setPreferredSizeCouldChange {
+static void MMMPreferredSizeChangesSetUp(void) {
+
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+
+		MMMPreferredSizePending = [NSMapTable strongToStrongObjectsMapTable];
+
+		// Delivering before UIKit and Core Animation handle the current transaction, i.e. before the next layout pass.
+		CFRunLoopObserverRef observer = CFRunLoopObserverCreateWithHandler(
+			kCFAllocatorDefault,
+			kCFRunLoopBeforeWaiting | kCFRunLoopExit,
+			YES,
+			1000,
+			^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+				[UIView mmm_deliverPreferredSizeChanges];
+			}
+		);
+		CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+		CFRelease(observer);
+	});
+}
+
+- (UIView<MMMPreferredSizeChanges> *)_mmm_preferredSizeChangesParent {
 
+	// Not caching this: the walk is short (stops at the first scroll view) and the calls are coalesced anyway,
+	// while tracking the hierarchy changes reliably would require hooking every view in the app.
+	UIView<MMMPreferredSizeChanges> *parent = nil;
 	UIView *next = self.superview;
 
 	while (next) {
 
 		if ([next conformsToProtocol:@protocol(MMMPreferredSizeChanges)]) {
-			[(id<MMMPreferredSizeChanges>)next mmm_preferredSizeCouldChangeForSubview:self];
+			parent = (UIView<MMMPreferredSizeChanges> *)next;
 			break;
 		}
 
@@ -26,6 +54,52 @@
 
 		next = next.superview;
 	}
+
+	return parent;
+}
+
+- (void)mmm_setPreferredSizeCouldChange {
+
+	NSAssert([NSThread isMainThread], @"%s should be called on the main thread", sel_getName(_cmd));
+
+	MMMPreferredSizeChangesSetUp();
+
+	UIView<MMMPreferredSizeChanges> *parent = [self _mmm_preferredSizeChangesParent];
+	if (!parent)
+		return;
+
+	NSMutableOrderedSet<UIView *> *subviews = [MMMPreferredSizePending objectForKey:parent];
+	if (!subviews) {
+		subviews = [[NSMutableOrderedSet alloc] init];
+		[MMMPreferredSizePending setObject:subviews forKey:parent];
+	}
+	[subviews addObject:self];
+}
+
++ (void)mmm_deliverPreferredSizeChanges {
+
+	if (MMMPreferredSizePending.count == 0)
+		return;
+
+	// Notifications might cause new changes, they are going to be delivered on the next round.
+	NSMapTable<UIView *, NSMutableOrderedSet<UIView *> *> *pending = [MMMPreferredSizePending copy];
+	[MMMPreferredSizePending removeAllObjects];
+
+	for (UIView<MMMPreferredSizeChanges> *parent in pending) {
+		NSArray<UIView *> *subviews = [[pending objectForKey:parent] array];
+		if ([parent respondsToSelector:@selector(mmm_preferredSizeCouldChangeForSubviews:)]) {
+			[parent mmm_preferredSizeCouldChangeForSubviews:subviews];
+		} else {
+			for (UIView *subview in subviews) {
+				[parent mmm_preferredSizeCouldChangeForSubview:subview];
+			}
+		}
+	}
+
+	if (MMMPreferredSizePending.count > 0) {
+		// Making sure the run loop does not go to sleep with something pending.
+		CFRunLoopWakeUp(CFRunLoopGetMain());
+	}
 }
 
 @end
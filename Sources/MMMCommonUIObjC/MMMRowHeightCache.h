@@ -0,0 +1,74 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+@import UIKit;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Remembers the heights of self-sizing rows, so the estimates given to a table view are exact for the content
+ * that was displayed before, possibly during one of the previous launches.
+ *
+ * The heights are keyed by a hash of the content of the row (something you compute from your view model),
+ * the width of the row and the content size category, so changing the font size or rotating the device
+ * does not return stale values.
+ *
+ * The storage is a fixed size open addressing hash table, which can be backed by a memory-mapped file:
+ * lookups read the mapped pages directly and there is nothing to serialize on exit. When the table is full,
+ * the least recently stored entries are overwritten.
+ *
+ * Not thread-safe, meant to be used on the main thread together with the corresponding table view.
+ *
+ * Typical usage in the delegate of the table view:
+ *
+ *	func tableView(_ tableView: UITableView, estimatedHeightForRowAt indexPath: IndexPath) -> CGFloat {
+ *		return heightCache.estimatedHeight(forContentHash: hash(at: indexPath), tableView: tableView, defaultHeight: 60)
+ *	}
+ *
+ *	func tableView(_ tableView: UITableView, willDisplay cell: UITableViewCell, forRowAt indexPath: IndexPath) {
+ *		heightCache.recordHeight(of: cell, contentHash: hash(at: indexPath), tableView: tableView)
+ *	}
+ */
+@interface MMMRowHeightCache : NSObject
+
+/**
+ * A cache persisted in the given file (a new one is created if it does not exist or has an incompatible format)
+ * or a purely in-memory one when the URL is nil. The capacity is rounded up to a power of 2.
+ */
+- (id)initWithFileURL:(nullable NSURL *)fileURL capacity:(NSInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+/** An in-memory cache with the default capacity. */
+- (id)init;
+
+/** The number of entries the table can hold. */
+@property (nonatomic, readonly) NSInteger capacity;
+
+/** The number of entries stored currently. */
+@property (nonatomic, readonly) NSInteger count;
+
+/** The height stored for the given key or 0 if there is none. */
+- (CGFloat)heightForContentHash:(uint64_t)contentHash width:(CGFloat)width contentSizeCategory:(NSString *)category;
+
+/** Remembers the height for the given key. Non-positive heights are ignored. */
+- (void)setHeight:(CGFloat)height forContentHash:(uint64_t)contentHash width:(CGFloat)width contentSizeCategory:(NSString *)category;
+
+/** Removes all the entries. */
+- (void)removeAllHeights;
+
+/** Flushes the changes to the file; not required for the changes to persist, but makes them durable right away. */
+- (void)synchronize;
+
+/**
+ * The height remembered for the row with the given content in the given table view (its current width and
+ * content size category are used) or `defaultHeight` if there is none yet.
+ */
+- (CGFloat)estimatedHeightForContentHash:(uint64_t)contentHash tableView:(UITableView *)tableView defaultHeight:(CGFloat)defaultHeight;
+
+/** Remembers the current height of the given cell displaying the content with the given hash in the table view. */
+- (void)recordHeightOfCell:(UITableViewCell *)cell contentHash:(uint64_t)contentHash tableView:(UITableView *)tableView;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,275 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+#import "MMMRowHeightCache.h"
+
+@import MMMLog;
+
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+// The layout of the table, the same in memory and in the file. Everything is little-endian as on all our devices.
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t capacity;
+	uint32_t count;
+	/**
+	 * Increases with every store, so we know which entries are the oldest ones.
+	 * 64 bits, so it never wraps around to 0 (an empty slot) even though it persists across launches.
+	 */
+	uint64_t stamp;
+	uint32_t reserved[2];
+} MMMRowHeightCacheHeader;
+
+typedef struct {
+	uint64_t contentHash;
+	/** 0 for empty slots. */
+	uint64_t stamp;
+	/** The width in quarters of a point. */
+	uint32_t width;
+	uint32_t category;
+	float height;
+	uint32_t reserved;
+} MMMRowHeightCacheEntry;
+
+static const uint32_t MMMRowHeightCacheMagic = 0x4348524D; // "MRHC"
+static const uint32_t MMMRowHeightCacheVersion = 2;
+
+/// How many slots are checked for every key before giving up (lookups) or overwriting the oldest one (stores).
+static const NSInteger MMMRowHeightCacheMaxProbes = 16;
+
+static const NSInteger MMMRowHeightCacheDefaultCapacity = 4096;
+
+static inline uint64_t MMMRowHeightCacheMix(uint64_t x) {
+	// The finalizer of SplitMix64.
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+static uint32_t MMMRowHeightCacheCategoryHash(NSString *category) {
+	// FNV-1a; only has to be stable across launches, unlike -[NSString hash].
+	uint32_t hash = 2166136261u;
+	for (const char *c = category.UTF8String; c && *c; c++) {
+		hash = (hash ^ (uint8_t)*c) * 16777619u;
+	}
+	return hash;
+}
+
+@implementation MMMRowHeightCache {
+	NSURL *_fileURL;
+	void *_storage;
+	size_t _length;
+	BOOL _mapped;
+	MMMRowHeightCacheHeader *_header;
+	MMMRowHeightCacheEntry *_entries;
+	uint32_t _mask;
+	// The hash of the last category seen, as it's almost always the same one.
+	NSString *_lastCategory;
+	uint32_t _lastCategoryHash;
+}
+
+- (id)initWithFileURL:(NSURL *)fileURL capacity:(NSInteger)capacity {
+
+	if (self = [super init]) {
+
+		NSAssert(capacity > 0 && capacity <= (1 << 24), @"");
+
+		uint32_t c = 1;
+		while (c < capacity)
+			c <<= 1;
+		_capacity = c;
+		_mask = c - 1;
+
+		_fileURL = fileURL;
+		_length = sizeof(MMMRowHeightCacheHeader) + _capacity * sizeof(MMMRowHeightCacheEntry);
+
+		if (_fileURL && [self mapFile]) {
+			_mapped = YES;
+		} else {
+			_storage = calloc(1, _length);
+		}
+
+		_header = _storage;
+		_entries = (MMMRowHeightCacheEntry *)((uint8_t *)_storage + sizeof(MMMRowHeightCacheHeader));
+
+		if (_header->magic != MMMRowHeightCacheMagic
+			|| _header->version != MMMRowHeightCacheVersion
+			|| _header->capacity != _capacity
+			|| _header->count > _capacity
+		) {
+			[self resetStorage];
+		}
+	}
+
+	return self;
+}
+
+- (id)init {
+	return [self initWithFileURL:nil capacity:MMMRowHeightCacheDefaultCapacity];
+}
+
+- (void)dealloc {
+	if (_mapped) {
+		munmap(_storage, _length);
+	} else {
+		free(_storage);
+	}
+}
+
+- (BOOL)mapFile {
+
+	const char *path = _fileURL.fileSystemRepresentation;
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		MMM_LOG_ERROR(@"Could not open the height cache at '%s': %d", path, errno);
+		return NO;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size != (off_t)_length) {
+		// A new file or a different capacity; the contents are going to be reset anyway.
+		if (ftruncate(fd, 0) != 0 || ftruncate(fd, _length) != 0) {
+			MMM_LOG_ERROR(@"Could not resize the height cache at '%s': %d", path, errno);
+			close(fd);
+			return NO;
+		}
+	}
+
+	void *storage = mmap(NULL, _length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (storage == MAP_FAILED) {
+		MMM_LOG_ERROR(@"Could not map the height cache at '%s': %d", path, errno);
+		return NO;
+	}
+
+	_storage = storage;
+	return YES;
+}
+
+- (void)resetStorage {
+	memset(_storage, 0, _length);
+	_header->magic = MMMRowHeightCacheMagic;
+	_header->version = MMMRowHeightCacheVersion;
+	_header->capacity = (uint32_t)_capacity;
+}
+
+- (NSInteger)count {
+	return _header->count;
+}
+
+- (uint32_t)hashForCategory:(NSString *)category {
+	if (category != _lastCategory && ![category isEqualToString:_lastCategory]) {
+		_lastCategory = [category copy];
+		_lastCategoryHash = MMMRowHeightCacheCategoryHash(category);
+	}
+	return _lastCategoryHash;
+}
+
+static inline uint32_t MMMRowHeightCacheWidth(CGFloat width) {
+	return (uint32_t)MAX(0, lround(width * 4));
+}
+
+static inline uint32_t MMMRowHeightCacheSlot(uint64_t contentHash, uint32_t width, uint32_t category, uint32_t mask) {
+	return (uint32_t)MMMRowHeightCacheMix(contentHash ^ ((uint64_t)width << 32 | category)) & mask;
+}
+
+static inline BOOL MMMRowHeightCacheEntryMatches(const MMMRowHeightCacheEntry *e, uint64_t contentHash, uint32_t width, uint32_t category) {
+	return e->contentHash == contentHash && e->width == width && e->category == category;
+}
+
+- (CGFloat)heightForContentHash:(uint64_t)contentHash width:(CGFloat)width contentSizeCategory:(NSString *)category {
+
+	uint32_t w = MMMRowHeightCacheWidth(width);
+	uint32_t c = [self hashForCategory:category];
+	uint32_t slot = MMMRowHeightCacheSlot(contentHash, w, c, _mask);
+
+	for (NSInteger i = 0; i < MMMRowHeightCacheMaxProbes; i++) {
+		const MMMRowHeightCacheEntry *e = &_entries[(slot + i) & _mask];
+		if (e->stamp == 0) {
+			// Entries are never removed individually, so the key cannot be further.
+			return 0;
+		}
+		if (MMMRowHeightCacheEntryMatches(e, contentHash, w, c))
+			return e->height;
+	}
+
+	return 0;
+}
+
+- (void)setHeight:(CGFloat)height forContentHash:(uint64_t)contentHash width:(CGFloat)width contentSizeCategory:(NSString *)category {
+
+	if (!(height > 0))
+		return;
+
+	uint32_t w = MMMRowHeightCacheWidth(width);
+	uint32_t c = [self hashForCategory:category];
+	uint32_t slot = MMMRowHeightCacheSlot(contentHash, w, c, _mask);
+
+	MMMRowHeightCacheEntry *target = NULL;
+	MMMRowHeightCacheEntry *oldest = NULL;
+	for (NSInteger i = 0; i < MMMRowHeightCacheMaxProbes; i++) {
+		MMMRowHeightCacheEntry *e = &_entries[(slot + i) & _mask];
+		if (e->stamp == 0) {
+			_header->count++;
+			target = e;
+			break;
+		}
+		if (MMMRowHeightCacheEntryMatches(e, contentHash, w, c)) {
+			if (e->height == (float)height) {
+				// Nothing to write, avoiding dirtying the page.
+				return;
+			}
+			target = e;
+			break;
+		}
+		if (!oldest || e->stamp < oldest->stamp)
+			oldest = e;
+	}
+	if (!target)
+		target = oldest;
+
+	target->contentHash = contentHash;
+	target->width = w;
+	target->category = c;
+	target->height = (float)height;
+	target->stamp = ++_header->stamp;
+}
+
+- (void)removeAllHeights {
+	[self resetStorage];
+}
+
+- (void)synchronize {
+	if (_mapped) {
+		if (msync(_storage, _length, MS_SYNC) != 0) {
+			MMM_LOG_ERROR(@"Could not flush the height cache: %d", errno);
+		}
+	}
+}
+
+- (CGFloat)estimatedHeightForContentHash:(uint64_t)contentHash tableView:(UITableView *)tableView defaultHeight:(CGFloat)defaultHeight {
+	CGFloat height = [self
+		heightForContentHash:contentHash
+		width:tableView.bounds.size.width
+		contentSizeCategory:tableView.traitCollection.preferredContentSizeCategory
+	];
+	return height > 0 ? height : defaultHeight;
+}
+
+- (void)recordHeightOfCell:(UITableViewCell *)cell contentHash:(uint64_t)contentHash tableView:(UITableView *)tableView {
+	[self
+		setHeight:cell.bounds.size.height
+		forContentHash:contentHash
+		width:tableView.bounds.size.width
+		contentSizeCategory:tableView.traitCollection.preferredContentSizeCategory
+	];
+}
+
+@end
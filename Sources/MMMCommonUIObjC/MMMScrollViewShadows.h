@@ -31,8 +31,26 @@ NS_ASSUME_NONNULL_BEGIN
  * are used with settings and the corresponding insets are not zero now. */
 - (void)layoutSubviewsWithClippingView:(nullable UIView *)clippingView;
 
+/**
+ * The number of property writes to the shadow and clipping views skipped by the layout methods above because
+ * the values were the same as the last applied ones. For diagnostics only.
+ */
+@property (nonatomic, readonly) NSInteger numberOfSuppressedWrites;
+
 @end
 
+/**
+ * The height of the top shadow when the top edge of the visible area is `top` points below the top of the content:
+ * the shadow grows from 0 to `maxHeight` as the content is scrolled away.
+ */
+extern CGFloat MMMScrollViewTopShadowHeight(CGFloat top, CGFloat maxHeight);
+
+/**
+ * The height of the bottom shadow when the bottom edge of the visible area is `distance` points above the end
+ * of the content.
+ */
+extern CGFloat MMMScrollViewBottomShadowHeight(CGFloat distance, CGFloat maxHeight);
+
 /**
  * Holds configuration for MMMScrollViewShadows that can be set only on initialization time.
  */
@@ -86,9 +104,24 @@ typedef NS_ENUM(NSInteger, MMMScrollViewShadowAlignment) {
 	MMMScrollViewShadowAlignmentBottom
 };
 
+/// The opacity of a top-aligned shadow of the given size at the given point (for the bottom one flip the vertical
+/// coordinate). The shadow is a radial gradient ending at the arc passing via the center of the bottom edge and
+/// both top corners, see `shadowCurvature`.
+extern CGFloat MMMScrollViewShadowOpacity(CGPoint point, CGSize size, CGFloat shadowAlpha, CGFloat curvature);
+
+/// Reference CPU rasterizer of shadow bitmaps: fills `width` by `height` pixels of premultiplied RGBA
+/// (black with opacity from `MMMScrollViewShadowOpacity()` sampled at pixel centers).
+extern void MMMScrollViewShadowRasterize(
+	uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow,
+	MMMScrollViewShadowAlignment alignment, CGFloat shadowAlpha, CGFloat curvature
+);
+
 /// A view that's used internally to render shadows in MMMAutoLayoutScrollView.
 /// Open for reuse in cases we want to display compatible shadows but differntly controlled.
 /// Note that this does not support Auto Layout, you have to manage its frame.
+///
+/// The shadow is rendered once per combination of its height, alpha, curvature and screen scale into a small bitmap
+/// shared by all the shadow views and stretched to their bounds, so resizing them costs nothing.
 @interface MMMScrollViewShadowView : UIView
 
 - (id)initWithAlignment:(MMMScrollViewShadowAlignment)alignment
@@ -7,6 +7,7 @@
 
 #import "MMMAnimations.h"
 #import "MMMCommonUIMisc.h"
+#import "MMMGradientRasterizer.h"
 
 //
 //
@@ -56,6 +57,87 @@
 //
 //
 
+/// The opacity of the shadow at the given normalized distance from the edge it is attached to.
+static inline CGFloat MMMScrollViewShadowOpacityForTime(CGFloat t, CGFloat shadowAlpha) {
+	return pow(
+		[MMMAnimation
+			interpolateFrom:shadowAlpha to:0
+			time:t
+			startTime:0 duration:1
+			curve:MMMAnimationCurveSofterEaseOut
+		],
+		M_SQRT2
+	);
+}
+
+/// The radius of the circle the shadow gradient ends at: the arc passing via the center of the bottom edge and
+/// both top corners (for the top shadow).
+static inline CGFloat MMMScrollViewShadowRadius(CGSize size, CGFloat curvature) {
+	CGFloat d = size.width * .5;
+	CGFloat h = size.height * MAX(.01, curvature);
+	return (d * d + h * h) / (2 * h);
+}
+
+CGFloat MMMScrollViewShadowOpacity(CGPoint point, CGSize size, CGFloat shadowAlpha, CGFloat curvature) {
+
+	if (size.width <= 0 || size.height <= 0)
+		return 0;
+
+	CGFloat radius = MMMScrollViewShadowRadius(size, curvature);
+
+	CGFloat dx = point.x - size.width * .5;
+	CGFloat dy = point.y - (size.height - radius);
+	CGFloat t = (sqrt(dx * dx + dy * dy) - (radius - size.height)) / size.height;
+	if (t < 0 || t > 1)
+		return 0;
+
+	return MMMScrollViewShadowOpacityForTime(t, shadowAlpha);
+}
+
+void MMMScrollViewShadowRasterize(
+	uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow,
+	MMMScrollViewShadowAlignment alignment, CGFloat shadowAlpha, CGFloat curvature
+) {
+	CGSize size = CGSizeMake(width, height);
+
+	for (NSInteger y = 0; y < height; y++) {
+
+		uint8_t *row = pixels + y * bytesPerRow;
+
+		// The bottom shadow is a flipped top one.
+		CGFloat sampleY = (alignment == MMMScrollViewShadowAlignmentTop) ? y + .5 : height - y - .5;
+
+		for (NSInteger x = 0; x < width; x++) {
+			CGFloat opacity = MMMScrollViewShadowOpacity(CGPointMake(x + .5, sampleY), size, shadowAlpha, curvature);
+			// Premultiplied black, so only alpha is non-zero.
+			row[x * 4 + 0] = row[x * 4 + 1] = row[x * 4 + 2] = 0;
+			row[x * 4 + 3] = (uint8_t)round(MAX(0, MIN(opacity, 1)) * 255);
+		}
+	}
+}
+
+/// Same as `MMMScrollViewShadowRasterize()`, but using the gradient rasterizer with a sampled opacity ramp,
+/// which is much faster and dithered.
+static void MMMScrollViewShadowBake(
+	uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow,
+	MMMScrollViewShadowAlignment alignment, CGFloat shadowAlpha, CGFloat curvature
+) {
+	const NSInteger rampCount = 32;
+	simd_float4 ramp[rampCount];
+	for (NSInteger i = 0; i < rampCount; i++) {
+		ramp[i] = simd_make_float4(0, 0, 0, MMMScrollViewShadowOpacityForTime((CGFloat)i / (rampCount - 1), shadowAlpha));
+	}
+
+	CGSize size = CGSizeMake(width, height);
+	CGFloat radius = MMMScrollViewShadowRadius(size, curvature);
+	simd_float2 center = simd_make_float2(
+		width * .5,
+		(alignment == MMMScrollViewShadowAlignmentTop) ? height - radius : radius
+	);
+
+	MMMGradientRasterizeRadial(pixels, width, height, bytesPerRow, ramp, rampCount, center, radius - height, radius);
+}
+
 @implementation MMMScrollViewShadowView {
 	MMMScrollViewShadowAlignment _alignment;
 	MMMScrollViewShadowsSettings *_settings;
@@ -69,78 +151,107 @@
 		_settings = settings;
 
 		self.opaque = NO;
-		self.contentMode = UIViewContentModeRedraw;
+		self.userInteractionEnabled = NO;
 
 		self.translatesAutoresizingMaskIntoConstraints = NO;
+
+		// Shared bitmap simply stretched to our bounds.
+		CGFloat scale = MMMPixelScale();
+		self.layer.contents = (__bridge id)[self.class
+			shadowImageWithAlignment:_alignment
+			height:(_alignment == MMMScrollViewShadowAlignmentTop) ? _settings.topShadowHeight : _settings.bottomShadowHeight
+			alpha:_settings.shadowAlpha
+			curvature:_settings.shadowCurvature
+			scale:scale
+		].CGImage;
+		self.layer.contentsScale = scale;
+		self.layer.contentsGravity = kCAGravityResize;
 	}
 
 	return self;
 }
 
-- (void)drawRect:(CGRect)rect {
-
-	CGRect b = self.bounds;
-
-	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-
-	const CGFloat shadowAlpha = _settings.shadowAlpha;
-
-	NSInteger numberOfSteps = MAX(8, MIN(b.size.height * 2, 24));
-	CGFloat *colors = alloca(4 * sizeof(CGFloat) * numberOfSteps);
-	CGFloat *steps = alloca(sizeof(CGFloat) * numberOfSteps);
-	for (NSInteger i = 0; i < numberOfSteps; i++) {
-		CGFloat t = (CGFloat)i / (numberOfSteps - 1);
-		steps[i] = t;
-		colors[i * 4 + 0] = 0;
-		colors[i * 4 + 1] = 0;
-		colors[i * 4 + 2] = 0;
-		colors[i * 4 + 3] = powf(
-			[MMMAnimation
-				interpolateFrom:shadowAlpha to:0
-				time:t
-				startTime:0 duration:1
-				curve:MMMAnimationCurveSofterEaseOut
-			],
-			M_SQRT2
-		);
-	}
-
-	CGGradientRef gradient = CGGradientCreateWithColorComponents(colorSpace, colors, steps, numberOfSteps);
-
-	CGColorSpaceRelease(colorSpace);
+/// The width the shadow bitmaps are rendered with. The shape of the curved shadow depends on the width,
+/// so stretching turns its circular border into an elliptical one, which is fine for our curvature settings.
+static const CGFloat MMMScrollViewShadowReferenceWidth = 64;
+
++ (UIImage *)shadowImageWithAlignment:(MMMScrollViewShadowAlignment)alignment
+	height:(CGFloat)height
+	alpha:(CGFloat)alpha
+	curvature:(CGFloat)curvature
+	scale:(CGFloat)scale
+{
+	static NSCache<NSString *, UIImage *> *cache = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		cache = [[NSCache alloc] init];
+	});
+
+	NSString *key = [NSString stringWithFormat:@"%ld:%.3f:%.3f:%.3f:%.1f", (long)alignment, height, alpha, curvature, scale];
+	UIImage *image = [cache objectForKey:key];
+	if (image)
+		return image;
+
+	NSInteger width = (NSInteger)ceil(MMMScrollViewShadowReferenceWidth * scale);
+	NSInteger pixelHeight = MAX(1, (NSInteger)ceil(height * scale));
+	NSInteger bytesPerRow = width * 4;
+
+	NSMutableData *data = [[NSMutableData alloc] initWithLength:bytesPerRow * pixelHeight];
+	MMMScrollViewShadowBake(data.mutableBytes, width, pixelHeight, bytesPerRow, alignment, alpha, curvature);
+
+	CGImageRef cgImage = MMMCreateImageWithPremultipliedRGBA(data, width, pixelHeight, bytesPerRow);
+	image = [UIImage imageWithCGImage:cgImage scale:scale orientation:UIImageOrientationUp];
+	CGImageRelease(cgImage);
+
+	[cache setObject:image forKey:key];
+
+	return image;
+}
 
-	// We want the radial gradient to end at the arc passing via the center of the bottom edge and both top corners (for the top shadow view)
-	CGFloat d = b.size.width * .5;
-	CGFloat h = b.size.height * MAX(.01, _settings.shadowCurvature);
-	CGFloat radius = (d * d + h * h) / (2 * h);
+@end
 
-	CGPoint center;
-	if (_alignment == MMMScrollViewShadowAlignmentTop) {
-		center = CGPointMake(b.origin.x + d, b.origin.y + b.size.height - radius);
-	} else {
-		NSAssert(_alignment == MMMScrollViewShadowAlignmentBottom, @"");
-		center = CGPointMake(b.origin.x + d, b.origin.y + radius);
-	}
+CGFloat MMMScrollViewTopShadowHeight(CGFloat top, CGFloat maxHeight) {
+	return [MMMAnimation
+		interpolateFrom:0 to:maxHeight
+		time:top
+		startTime:0 duration:MAX(40, 4 * maxHeight)
+		curve:MMMAnimationCurveEaseInOut
+	];
+}
 
-	CGContextRef c = UIGraphicsGetCurrentContext();
+CGFloat MMMScrollViewBottomShadowHeight(CGFloat distance, CGFloat maxHeight) {
+	return [MMMAnimation
+		interpolateFrom:0 to:maxHeight
+		time:distance
+		startTime:maxHeight duration:MAX(40, 4 * maxHeight)
+		curve:MMMAnimationCurveEaseInOut
+	];
+}
 
-	CGContextDrawRadialGradient(
-		c, gradient,
-		center, radius - b.size.height,
-		center, radius,
-		0
-	);
+/// What was applied to one of our views last time, so we can avoid touching it when nothing changes.
+typedef struct {
+	BOOL valid;
+	CGRect frame;
+	BOOL hidden;
+} MMMScrollViewShadowsViewState;
 
-	CGGradientRelease(gradient);
-}
+typedef struct {
+	BOOL valid;
+	CGRect frame;
+	BOOL clipsToBounds;
+} MMMScrollViewShadowsClippingViewState;
 
-@end
+static const CGFloat MMMScrollViewShadowsZPosition = 1000;
 
 @implementation MMMScrollViewShadows {
 	UIScrollView * __weak _scrollView;
 	MMMScrollViewShadowsSettings *_settings;
 	MMMScrollViewShadowView *_topShadowView;
 	MMMScrollViewShadowView *_bottomShadowView;
+	MMMScrollViewShadowsViewState _topShadowState;
+	MMMScrollViewShadowsViewState _bottomShadowState;
+	MMMScrollViewShadowsClippingViewState _clippingViewState;
+	UIView * __weak _clippingView;
 }
 
 - (id)initWithScrollView:(UIScrollView *)scrollView settings:(MMMScrollViewShadowsSettings *)settings {
@@ -150,13 +261,18 @@
 		_scrollView = scrollView;
 		_settings = settings;
 
+		// Shadows are kept above the content via zPosition instead of being brought to front on every layout pass.
+		// (They don't handle touches, so it does not matter for hit-testing that they are not the last subviews.)
+
 		if (_settings.topShadowEnabled) {
 			_topShadowView = [[MMMScrollViewShadowView alloc] initWithAlignment:MMMScrollViewShadowAlignmentTop settings:_settings];
+			_topShadowView.layer.zPosition = MMMScrollViewShadowsZPosition;
 			[_scrollView addSubview:_topShadowView];
 		}
 
 		if (_settings.bottomShadowEnabled) {
 			_bottomShadowView = [[MMMScrollViewShadowView alloc] initWithAlignment:MMMScrollViewShadowAlignmentBottom settings:_settings];
+			_bottomShadowView.layer.zPosition = MMMScrollViewShadowsZPosition;
 			[_scrollView addSubview:_bottomShadowView];
 		}
 	}
@@ -172,6 +288,30 @@
 	[self layoutSubviewsWithClippingView:nil];
 }
 
+- (void)applyFrame:(CGRect)frame hidden:(BOOL)hidden toView:(UIView *)view state:(MMMScrollViewShadowsViewState *)state {
+
+	if (!state->valid) {
+		state->valid = YES;
+		state->hidden = !hidden;
+		state->frame = CGRectNull;
+	}
+
+	if (state->hidden != hidden) {
+		state->hidden = hidden;
+		view.hidden = hidden;
+	} else {
+		_numberOfSuppressedWrites++;
+	}
+
+	// No need to move a hidden view around, the frame will be updated when it's visible again.
+	if (!hidden && !CGRectEqualToRect(state->frame, frame)) {
+		state->frame = frame;
+		view.frame = frame;
+	} else {
+		_numberOfSuppressedWrites++;
+	}
+}
+
 - (void)layoutSubviewsWithClippingView:(nullable UIView *)clippingView {
 
 	UIEdgeInsets contentInsets;
@@ -196,54 +336,63 @@
 	if (_topShadowView) {
 
 		CGFloat top = CGRectGetMinY(b);
-
-		CGFloat topShadowHeight = [MMMAnimation
-			interpolateFrom:0 to:_settings.topShadowHeight
-			time:top
-			startTime:0 duration:MAX(40, 4 * _settings.topShadowHeight)
-			curve:MMMAnimationCurveEaseInOut
-		];
-
-		_topShadowView.frame = CGRectMake(CGRectGetMinX(b), top, b.size.width, topShadowHeight);
+		CGFloat topShadowHeight = MMMScrollViewTopShadowHeight(top, _settings.topShadowHeight);
 
 		BOOL hidden = topShadowHeight < 1;
-		_topShadowView.hidden = hidden;
+		[self
+			applyFrame:CGRectMake(CGRectGetMinX(b), top, b.size.width, topShadowHeight)
+			hidden:hidden
+			toView:_topShadowView
+			state:&_topShadowState
+		];
 
 		if (clippingView)
 			needsClipping = needsClipping || (!hidden && contentInsets.top > 0);
-
-		if (!_topShadowView.hidden)
-			[_scrollView bringSubviewToFront:_topShadowView];
 	}
 
 	if (_bottomShadowView) {
 
 		CGFloat bottom = CGRectGetMaxY(b);
-
-		CGFloat bottomShadowHeight = [MMMAnimation
-			interpolateFrom:0 to:_settings.bottomShadowHeight
-			time:_scrollView.contentSize.height - bottom
-			startTime:_settings.bottomShadowHeight
-			duration:MAX(40, 4 * _settings.bottomShadowHeight)
-			curve:MMMAnimationCurveEaseInOut
-		];
-
-		_bottomShadowView.frame = CGRectMake(CGRectGetMinX(b), bottom - bottomShadowHeight, b.size.width, bottomShadowHeight);
+		CGFloat bottomShadowHeight = MMMScrollViewBottomShadowHeight(
+			_scrollView.contentSize.height - bottom,
+			_settings.bottomShadowHeight
+		);
 
 		BOOL hidden = bottomShadowHeight < 1;
-		_bottomShadowView.hidden = hidden;
+		[self
+			applyFrame:CGRectMake(CGRectGetMinX(b), bottom - bottomShadowHeight, b.size.width, bottomShadowHeight)
+			hidden:hidden
+			toView:_bottomShadowView
+			state:&_bottomShadowState
+		];
 
 		if (clippingView)
 			needsClipping = needsClipping || (!hidden && contentInsets.bottom > 0);
-
-		if (!_bottomShadowView.hidden)
-			[_scrollView bringSubviewToFront:_bottomShadowView];
 	}
 
 	if (clippingView) {
+
+		if (clippingView != _clippingView) {
+			_clippingView = clippingView;
+			_clippingViewState.valid = NO;
+		}
+
 		// Conversion is not really needed as _scrollView is actually the superview, but we don't enforce it.
-		clippingView.frame = [_scrollView convertRect:b toView:clippingView.superview];
-		clippingView.clipsToBounds = needsClipping;
+		CGRect frame = [_scrollView convertRect:b toView:clippingView.superview];
+
+		if (!_clippingViewState.valid || !CGRectEqualToRect(_clippingViewState.frame, frame)) {
+			clippingView.frame = frame;
+			_clippingViewState.frame = frame;
+		} else {
+			_numberOfSuppressedWrites++;
+		}
+		if (!_clippingViewState.valid || _clippingViewState.clipsToBounds != needsClipping) {
+			clippingView.clipsToBounds = needsClipping;
+			_clippingViewState.clipsToBounds = needsClipping;
+		} else {
+			_numberOfSuppressedWrites++;
+		}
+		_clippingViewState.valid = YES;
 	}
 }
 
@@ -57,6 +57,18 @@ typedef void (^ _Nonnull MMMShadowViewSettingBlock)(MMMShadowViewSetting *settin
 
 @property (nonatomic, readwrite, nullable) NSArray<MMMShadowViewSetting *> *settings;
 
+/**
+ * When enabled, then instead of letting Core Animation render a shadow for every setting, the shadows are drawn from
+ * blurred nine-slice bitmaps baked once per setting (and screen scale) and shared between all the instances.
+ *
+ * The baked shadow approximates the one of a rounded rectangle and is meant for lots of identical cards in feeds;
+ * the views should be larger than the shadow's corner radius plus its blur extent for the slices to fit.
+ *
+ * Note that `shadowPath` is always set for the layers even when this is disabled, so Core Animation does not need
+ * to render their contents offscreen. Disabled by default.
+ */
+@property (nonatomic, readwrite) BOOL bakesShadows;
+
 - (id)init;
 - (id)initWithSettings:(nullable NSArray<MMMShadowViewSetting *> *)settings;
 
@@ -65,4 +77,18 @@ typedef void (^ _Nonnull MMMShadowViewSettingBlock)(MMMShadowViewSetting *settin
 
 @end
 
+/**
+ * The radius of a box blur that, being applied `passes` times, approximates a Gaussian blur with the given sigma.
+ * (3 passes are typically close enough.)
+ */
+extern NSInteger MMMShadowBoxBlurRadiusForSigma(CGFloat sigma, NSInteger passes);
+
+/**
+ * Blurs a single channel 8-bit image in place by running `passes` horizontal and then vertical box blurs
+ * of the given radius. Pixels outside of the image are treated as zeros.
+ *
+ * This is what baked shadows of `MMMShadowView` are made with.
+ */
+extern void MMMShadowBoxBlur(uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow, NSInteger radius, NSInteger passes);
+
 NS_ASSUME_NONNULL_END
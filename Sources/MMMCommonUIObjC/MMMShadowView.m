@@ -5,6 +5,9 @@
 
 #import "MMMShadowView.h"
 
+#import "MMMCommonUIMisc.h"
+#import "MMMGradientRasterizer.h"
+
 /**
  * Something that holds both a CALayer & MMMShadowViewSettings together.
  */
@@ -12,13 +15,122 @@
 
 @property (nonatomic, readonly) CALayer *layer;
 
+/** The layer displaying the baked shadow, if `bakesShadows` was enabled. */
+@property (nonatomic, readonly) CALayer *shadowLayer;
+
 @property (nonatomic, readonly) MMMShadowViewSetting *setting;
 
-- (id)initWithLayer:(CALayer *)layer setting:(MMMShadowViewSetting *)setting NS_DESIGNATED_INITIALIZER;
+/** The frame last applied to the layer, so the shadow path is regenerated only when the size changes. */
+@property (nonatomic, readwrite) CGRect lastFrame;
+
+- (id)initWithLayer:(CALayer *)layer shadowLayer:(CALayer *)shadowLayer setting:(MMMShadowViewSetting *)setting NS_DESIGNATED_INITIALIZER;
 - (id)init NS_UNAVAILABLE;
 
 @end
 
+/**
+ * Geometry of a baked nine-slice shadow, all in pixels. The bitmap is a square with a rounded rectangle in the middle
+ * blurred all the way to its edges; the rectangle is wide enough for the central row and column to be exactly
+ * the same as for an infinitely large one, so they can be stretched.
+ */
+typedef struct {
+	/** How far the blur spreads beyond the shape. */
+	NSInteger extent;
+	/** The corner radius of the shape. */
+	NSInteger cornerRadius;
+	/** The radius of the box blur to apply 3 times to approximate the Gaussian one. */
+	NSInteger blurRadius;
+	/** The width and height of the bitmap. */
+	NSInteger size;
+} MMMShadowNineSlice;
+
+static const NSInteger MMMShadowBlurPasses = 3;
+
+static MMMShadowNineSlice MMMShadowNineSliceForSetting(MMMShadowViewSetting *setting, CGFloat scale) {
+	// Core Animation's shadowRadius is close to the standard deviation of the Gaussian blur it applies.
+	CGFloat sigma = MAX(0, setting.radius) * scale;
+	MMMShadowNineSlice slice;
+	slice.blurRadius = MMMShadowBoxBlurRadiusForSigma(sigma, MMMShadowBlurPasses);
+	slice.extent = slice.blurRadius * MMMShadowBlurPasses;
+	slice.cornerRadius = (NSInteger)ceil(MAX(0, setting.cornerRadius) * scale);
+	slice.size = 2 * slice.cornerRadius + 4 * slice.extent + 1;
+	return slice;
+}
+
+/// Coverage of a rounded rectangle with the given pixel-aligned bounds and corner radius, as alpha.
+static void MMMShadowRasterizeRoundedRect(uint8_t *pixels, NSInteger bytesPerRow, NSInteger origin, NSInteger size, CGFloat cornerRadius) {
+
+	float half = size * .5f;
+	float r = MIN(cornerRadius, half);
+	simd_float2 center = simd_make_float2(origin + half, origin + half);
+
+	for (NSInteger y = origin; y < origin + size; y++) {
+		uint8_t *row = pixels + y * bytesPerRow;
+		for (NSInteger x = origin; x < origin + size; x++) {
+			// Signed distance from the center of the pixel to the border of the rounded rectangle.
+			simd_float2 q = simd_abs(simd_make_float2(x + .5f, y + .5f) - center) - (half - r);
+			float d = simd_length(simd_max(q, simd_make_float2(0, 0))) + MIN(MAX(q.x, q.y), 0) - r;
+			row[x] = (uint8_t)lroundf(simd_clamp(.5f - d, 0.0f, 1.0f) * 255);
+		}
+	}
+}
+
+/// Bakes the shadow for the given setting into a premultiplied RGBA8 bitmap.
+static CGImageRef MMMShadowCreateNineSliceImage(MMMShadowViewSetting *setting, MMMShadowNineSlice slice) {
+
+	NSInteger size = slice.size;
+
+	// The shape is in the middle, inset by the blur extent from the edges.
+	NSMutableData *mask = [[NSMutableData alloc] initWithLength:size * size];
+	MMMShadowRasterizeRoundedRect(mask.mutableBytes, size, slice.extent, size - 2 * slice.extent, slice.cornerRadius);
+	MMMShadowBoxBlur(mask.mutableBytes, size, size, size, slice.blurRadius, MMMShadowBlurPasses);
+
+	CGFloat c[4] = { 0, 0, 0, 1 };
+	if (![setting.color getRed:&c[0] green:&c[1] blue:&c[2] alpha:&c[3]]) {
+		if ([setting.color getWhite:&c[0] alpha:&c[3]]) {
+			c[1] = c[2] = c[0];
+		} else {
+			NSCAssert(NO, @"The shadow color should be either RGB or grayscale");
+		}
+	}
+	simd_float4 color = simd_make_float4(c[0], c[1], c[2], c[3] * MAX(0, MIN(setting.opacity, 1)));
+
+	NSInteger bytesPerRow = size * 4;
+	NSMutableData *data = [[NSMutableData alloc] initWithLength:bytesPerRow * size];
+	const uint8_t *src = mask.bytes;
+	uint8_t *dst = data.mutableBytes;
+	for (NSInteger i = 0; i < size * size; i++) {
+		float a = color.w * src[i] / 255.0f;
+		simd_float4 v = simd_make_float4(color.xyz * a, a) * 255.0f + .5f;
+		simd_uchar4 p = simd_uchar(simd_clamp(v, 0.0f, 255.0f));
+		memcpy(dst + i * 4, &p, 4);
+	}
+
+	return MMMCreateImageWithPremultipliedRGBA(data, size, size, bytesPerRow);
+}
+
+/// The baked shadow for the given setting shared between all the views.
+static id MMMShadowNineSliceContents(MMMShadowViewSetting *setting, MMMShadowNineSlice slice, CGFloat scale) {
+
+	static NSCache<NSString *, id> *cache = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		cache = [[NSCache alloc] init];
+	});
+
+	NSString *key = [NSString stringWithFormat:@"%@:%.3f:%.3f:%.3f:%.1f",
+		setting.color, setting.opacity, setting.radius, setting.cornerRadius, scale
+	];
+	id contents = [cache objectForKey:key];
+	if (contents)
+		return contents;
+
+	contents = (__bridge_transfer id)MMMShadowCreateNineSliceImage(setting, slice);
+	[cache setObject:contents forKey:key];
+
+	return contents;
+}
+
 #pragma mark - MMMShadowView
 
 @implementation MMMShadowView {
@@ -78,7 +190,36 @@
 	[CATransaction setDisableActions:YES];
 	
 	for (MMMShadowLayerInfo *info in _layerInfo) {
-		info.layer.frame = UIEdgeInsetsInsetRect(_contentView.frame, info.setting.insets);
+
+		MMMShadowViewSetting *setting = info.setting;
+		CGRect frame = UIEdgeInsetsInsetRect(_contentView.frame, setting.insets);
+		// Positive insets can be larger than the content view itself, leaving no shape to cast a shadow.
+		frame.size = CGSizeMake(MAX(0, frame.size.width), MAX(0, frame.size.height));
+		CGRect lastFrame = info.lastFrame;
+		if (CGRectEqualToRect(frame, lastFrame))
+			continue;
+		info.lastFrame = frame;
+
+		info.layer.frame = frame;
+
+		if (info.shadowLayer) {
+			// The baked shadow spreads beyond the shape by the blur extent.
+			CGFloat extent = MMMShadowNineSliceForSetting(setting, info.shadowLayer.contentsScale).extent / info.shadowLayer.contentsScale;
+			info.shadowLayer.frame = CGRectInset(CGRectOffset(frame, setting.offset.width, setting.offset.height), -extent, -extent);
+			info.shadowLayer.hidden = CGRectIsEmpty(frame);
+		} else if (CGRectIsEmpty(frame)) {
+			info.layer.shadowPath = NULL;
+		} else if (!CGSizeEqualToSize(frame.size, lastFrame.size)) {
+			// Without an explicit path Core Animation has to render the layer offscreen to find its shape.
+			CGPathRef path = CGPathCreateWithRoundedRect(
+				CGRectMake(0, 0, frame.size.width, frame.size.height),
+				MIN(setting.cornerRadius, frame.size.width / 2),
+				MIN(setting.cornerRadius, frame.size.height / 2),
+				NULL
+			);
+			info.layer.shadowPath = path;
+			CGPathRelease(path);
+		}
 	}
 	
 	[CATransaction commit];
@@ -91,10 +232,18 @@
 	}	
 }
 
+- (void)setBakesShadows:(BOOL)bakesShadows {
+	if (_bakesShadows != bakesShadows) {
+		_bakesShadows = bakesShadows;
+		[self createLayers];
+	}
+}
+
 - (void)createLayers {
 	
 	for (MMMShadowLayerInfo *info in _layerInfo) {
 		[info.layer removeFromSuperlayer];
+		[info.shadowLayer removeFromSuperlayer];
 	}
 	[_layerInfo removeAllObjects];
 	
@@ -105,22 +254,39 @@
 	
 	for (MMMShadowViewSetting *setting in _settings) {
 	
+		CALayer *shadowLayer = nil;
+		if (_bakesShadows) {
+			CGFloat scale = MMMPixelScale();
+			MMMShadowNineSlice slice = MMMShadowNineSliceForSetting(setting, scale);
+			shadowLayer = [CALayer layer];
+			shadowLayer.contents = MMMShadowNineSliceContents(setting, slice, scale);
+			shadowLayer.contentsScale = scale;
+			shadowLayer.contentsGravity = kCAGravityResize;
+			// Only the central row and column of the bitmap are stretched.
+			CGFloat center = (CGFloat)((slice.size - 1) / 2) / slice.size;
+			shadowLayer.contentsCenter = CGRectMake(center, center, 1.0 / slice.size, 1.0 / slice.size);
+			[self.layer addSublayer:shadowLayer];
+		}
+
 		CALayer *layer = [CALayer layer];
 		layer.backgroundColor = setting.backgroundColor.CGColor;
-		layer.shadowColor = setting.color.CGColor;
-		layer.shadowOffset = setting.offset;
-		layer.shadowRadius = setting.radius;
-		layer.shadowOpacity = setting.opacity;
 		layer.cornerRadius = setting.cornerRadius;
+		if (!shadowLayer) {
+			layer.shadowColor = setting.color.CGColor;
+			layer.shadowOffset = setting.offset;
+			layer.shadowRadius = setting.radius;
+			layer.shadowOpacity = setting.opacity;
+		}
 
 		[self.layer addSublayer:layer];
 		
-		[_layerInfo addObject:[[MMMShadowLayerInfo alloc] initWithLayer:layer setting:setting]];
+		[_layerInfo addObject:[[MMMShadowLayerInfo alloc] initWithLayer:layer shadowLayer:shadowLayer setting:setting]];
 	}
 	
 	[self bringSubviewToFront:_contentView];
 	
 	[self invalidateIntrinsicContentSize];
+	[self setNeedsLayout];
 }
 
 - (UIEdgeInsets)alignmentRectInsets {
@@ -192,15 +358,70 @@
 
 @implementation MMMShadowLayerInfo
 
-- (id)initWithLayer:(CALayer *)layer setting:(MMMShadowViewSetting *)setting 
+- (id)initWithLayer:(CALayer *)layer shadowLayer:(CALayer *)shadowLayer setting:(MMMShadowViewSetting *)setting 
 {
 	self = [super init];
     if (self) {
         
         _layer = layer;
+        _shadowLayer = shadowLayer;
         _setting = setting;
+        _lastFrame = CGRectNull;
     }
     return self;
 }
 
 @end
+
+#pragma mark - Blur
+
+NSInteger MMMShadowBoxBlurRadiusForSigma(CGFloat sigma, NSInteger passes) {
+	// The variance of a box blur with radius r is r * (r + 1) / 3 and it adds up with every pass.
+	if (sigma <= 0 || passes <= 0)
+		return 0;
+	return MAX(1, (NSInteger)round((sqrt(1 + 12 * sigma * sigma / passes) - 1) / 2));
+}
+
+/// One box blur pass over a line of `count` pixels located `stride` bytes apart.
+static void MMMShadowBoxBlurLine(uint8_t *line, NSInteger count, NSInteger stride, NSInteger radius, uint8_t *scratch) {
+
+	for (NSInteger i = 0; i < count; i++) {
+		scratch[i] = line[i * stride];
+	}
+
+	const NSInteger window = 2 * radius + 1;
+
+	// Running sum of the window centered at the current pixel.
+	NSInteger sum = 0;
+	for (NSInteger i = 0; i <= MIN(radius, count - 1); i++) {
+		sum += scratch[i];
+	}
+	for (NSInteger i = 0; i < count; i++) {
+		line[i * stride] = (uint8_t)((sum + window / 2) / window);
+		if (i + radius + 1 < count)
+			sum += scratch[i + radius + 1];
+		if (i - radius >= 0)
+			sum -= scratch[i - radius];
+	}
+}
+
+void MMMShadowBoxBlur(uint8_t *pixels, NSInteger width, NSInteger height, NSInteger bytesPerRow, NSInteger radius, NSInteger passes) {
+
+	if (radius <= 0 || width <= 0 || height <= 0)
+		return;
+
+	uint8_t *scratch = malloc(MAX(width, height));
+
+	for (NSInteger pass = 0; pass < passes; pass++) {
+		for (NSInteger y = 0; y < height; y++) {
+			MMMShadowBoxBlurLine(pixels + y * bytesPerRow, width, 1, radius, scratch);
+		}
+	}
+	for (NSInteger pass = 0; pass < passes; pass++) {
+		for (NSInteger x = 0; x < width; x++) {
+			MMMShadowBoxBlurLine(pixels + x, height, bytesPerRow, radius, scratch);
+		}
+	}
+
+	free(scratch);
+}
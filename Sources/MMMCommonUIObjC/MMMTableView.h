@@ -26,12 +26,26 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithFrame:(CGRect)frame NS_UNAVAILABLE;
 - (instancetype)init NS_UNAVAILABLE;
 
-/// When enabled, then `reloadData` is automatically called whenever any of the cells report potential size
-/// changes via `mmm_setPreferredSizeCouldChange`. See `MMMPreferredSizeChanges` for more info.
+/// When enabled, then the heights of the rows are automatically updated whenever any of the cells report potential
+/// size changes via `mmm_setPreferredSizeCouldChange`. See `MMMPreferredSizeChanges` for more info.
+///
+/// Notifications are coalesced till the next run of the main queue and only the rows of the cells that have reported
+/// them are invalidated within a batch update, keeping the content offset. Other cells are not reconfigured.
+/// (`reloadData` is used only when a notification comes from a view that is not a part of a visible cell.)
 ///
 /// This feature is disabled by default for compatibility with the current code.
 @property (nonatomic, readwrite) BOOL shouldHandlePotentialCellSizeChanges;
 
+/// The number of batch updates performed due to potential cell size changes. For diagnostics only.
+@property (nonatomic, readonly) NSInteger numberOfSizeInvalidations;
+
+/// The total number of rows invalidated by all the batch updates counted in `numberOfSizeInvalidations`,
+/// i.e. the number of cells that had their layout invalidated (they are not reconfigured). For diagnostics only.
+@property (nonatomic, readonly) NSInteger numberOfInvalidatedRows;
+
+/// The number of times `reloadData` had to be used instead of targeted invalidation. For diagnostics only.
+@property (nonatomic, readonly) NSInteger numberOfSizeReloads;
+
 @end
 
 NS_ASSUME_NONNULL_END
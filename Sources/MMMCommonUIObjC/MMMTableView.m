@@ -8,6 +8,8 @@
 @implementation MMMTableView {
 	MMMScrollViewShadows *_shadows;
 	dispatch_source_t _reloadSource;
+	NSHashTable<UITableViewCell *> *_invalidatedCells;
+	BOOL _needsReload;
 }
 
 - (id)initWithSettings:(MMMScrollViewShadowsSettings *)settings style:(UITableViewStyle)style {
@@ -31,20 +33,49 @@
 	[_shadows layoutSubviews];
 }
 
+- (UITableViewCell *)cellContainingView:(UIView *)view {
+
+	// The closest cell that is ours, i.e. not a cell of some nested table view.
+	for (UIView *v = view; v && v != self; v = v.superview) {
+		if ([v isKindOfClass:[UITableViewCell class]] && [self indexPathForCell:(UITableViewCell *)v])
+			return (UITableViewCell *)v;
+	}
+
+	return nil;
+}
+
 - (void)mmm_preferredSizeCouldChangeForSubview:(UIView *)subview {
+	[self mmm_preferredSizeCouldChangeForSubviews:@[ subview ]];
+}
+
+- (void)mmm_preferredSizeCouldChangeForSubviews:(NSArray<UIView *> *)subviews {
 
 	if (!_shouldHandlePotentialCellSizeChanges) {
 		// Not opted in, nothing to do.
 		return;
 	}
 
-	// We want to coalesce multiple notifications into a single `reloadData` call.
+	// Collecting the cells to invalidate till the source fires. Not their index paths, as rows can be inserted
+	// or deleted in the meantime; and weakly, as the cells can go as well.
+	for (UIView *subview in subviews) {
+		UITableViewCell *cell = [self cellContainingView:subview];
+		if (cell) {
+			if (!_invalidatedCells)
+				_invalidatedCells = [NSHashTable weakObjectsHashTable];
+			[_invalidatedCells addObject:cell];
+		} else {
+			// Probably a header or a footer, nothing more targeted to do.
+			_needsReload = YES;
+		}
+	}
+
+	// We want to coalesce multiple notifications into a single update.
 	if (!_reloadSource) {
 		_reloadSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_OR, 0, 0, dispatch_get_main_queue());
 		if (_reloadSource) {
 			MMMTableView * __weak weakSelf = self;
 			dispatch_source_set_event_handler(_reloadSource, ^{
-				[weakSelf reloadData];
+				[weakSelf applyPotentialSizeChanges];
 			});
 			dispatch_activate(_reloadSource);
 		}
@@ -53,4 +84,49 @@
 	dispatch_source_merge_data(_reloadSource, 1);
 }
 
+- (void)applyPotentialSizeChanges {
+
+	NSHashTable<UITableViewCell *> *invalidatedCells = _invalidatedCells;
+	_invalidatedCells = nil;
+
+	if (_needsReload) {
+		_needsReload = NO;
+		_numberOfSizeReloads++;
+		[self reloadData];
+		return;
+	}
+
+	// The cells might have been scrolled away or reused since the notifications, only the visible ones matter.
+	NSMutableArray<UITableViewCell *> *cells = [[NSMutableArray alloc] initWithCapacity:invalidatedCells.count];
+	for (UITableViewCell *cell in invalidatedCells) {
+		if ([self indexPathForCell:cell])
+			[cells addObject:cell];
+	}
+	if (cells.count == 0)
+		return;
+
+	_numberOfSizeInvalidations++;
+	_numberOfInvalidatedRows += cells.count;
+
+	CGPoint contentOffset = self.contentOffset;
+
+	[UIView performWithoutAnimation:^{
+		[self performBatchUpdates:^{
+			// The batch makes the table view query the heights again without reconfiguring cells; self-sizing cells
+			// are measured anew only when their layout is invalidated.
+			for (UITableViewCell *cell in cells) {
+				[cell.contentView setNeedsLayout];
+				[cell invalidateIntrinsicContentSize];
+			}
+		} completion:nil];
+	}];
+
+	// Keeping the content where it was as much as the new content size allows it.
+	UIEdgeInsets insets = self.adjustedContentInset;
+	CGFloat maxOffsetY = MAX(-insets.top, self.contentSize.height + insets.bottom - self.bounds.size.height);
+	contentOffset.y = MAX(-insets.top, MIN(contentOffset.y, maxOffsetY));
+	if (!CGPointEqualToPoint(self.contentOffset, contentOffset))
+		self.contentOffset = contentOffset;
+}
+
 @end
@@ -5,6 +5,8 @@
 
 #import "MMMVerticalGradientView.h"
 
+#import "MMMGradientRasterizer.h"
+
 @implementation MMMVerticalGradientView {
 	UIColor *_topColor;
 	UIColor *_bottomColor;
@@ -36,6 +38,63 @@
 	return self;
 }
 
+/// Components of the given color in the device RGB space, NO if the color is not RGB or grayscale.
+static BOOL MMMVerticalGradientViewComponents(UIColor *color, simd_float4 *components) {
+	CGFloat c[4];
+	if ([color getRed:&c[0] green:&c[1] blue:&c[2] alpha:&c[3]]) {
+		*components = simd_make_float4(c[0], c[1], c[2], c[3]);
+		return YES;
+	} else if ([color getWhite:&c[0] alpha:&c[3]]) {
+		*components = simd_make_float4(c[0], c[0], c[0], c[3]);
+		return YES;
+	} else {
+		return NO;
+	}
+}
+
+/// A gradient shared between all the views having the same colors, curve and the number of steps.
+/// The ramp is computed once into packed arrays and handed over to Core Graphics without any intermediate objects.
+/// Follows the create rule, so the gradient stays alive for the caller even if the cache evicts it right away.
+static CGGradientRef MMMVerticalGradientViewCreateGradient(simd_float4 top, simd_float4 bottom, MMMAnimationCurve curve, NSInteger numberOfSteps) CF_RETURNS_RETAINED;
+
+static CGGradientRef MMMVerticalGradientViewCreateGradient(simd_float4 top, simd_float4 bottom, MMMAnimationCurve curve, NSInteger numberOfSteps) {
+
+	static NSCache<NSString *, id> *cache = nil;
+	static CGColorSpaceRef colorSpace = NULL;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		cache = [[NSCache alloc] init];
+		colorSpace = CGColorSpaceCreateDeviceRGB();
+	});
+
+	NSString *key = [NSString stringWithFormat:@"%.4f,%.4f,%.4f,%.4f:%.4f,%.4f,%.4f,%.4f:%ld:%ld",
+		top.x, top.y, top.z, top.w,
+		bottom.x, bottom.y, bottom.z, bottom.w,
+		(long)curve, (long)numberOfSteps
+	];
+	id cached = [cache objectForKey:key];
+	if (cached)
+		return CGGradientRetain((__bridge CGGradientRef)cached);
+
+	simd_float4 *ramp = alloca(numberOfSteps * sizeof(simd_float4));
+	MMMGradientRampFill(ramp, numberOfSteps, top, bottom, curve);
+
+	CGFloat *components = alloca(numberOfSteps * 4 * sizeof(CGFloat));
+	CGFloat *locations = alloca(numberOfSteps * sizeof(CGFloat));
+	for (NSInteger i = 0; i < numberOfSteps; i++) {
+		locations[i] = (CGFloat)i / (numberOfSteps - 1);
+		components[i * 4 + 0] = ramp[i].x;
+		components[i * 4 + 1] = ramp[i].y;
+		components[i * 4 + 2] = ramp[i].z;
+		components[i * 4 + 3] = ramp[i].w;
+	}
+
+	CGGradientRef gradient = CGGradientCreateWithColorComponents(colorSpace, components, locations, numberOfSteps);
+	[cache setObject:(__bridge id)gradient forKey:key];
+
+	return gradient;
+}
+
 - (void)drawRect:(CGRect)rect {
 
 	CGRect b = self.bounds;
@@ -43,18 +102,16 @@
 	CGContextRef c = UIGraphicsGetCurrentContext();
 
 	NSInteger numberOfSteps = (_curve == MMMAnimationCurveLinear) ? 2 : MIN(1 + CGRectGetHeight(b) / 5, 50);
+	numberOfSteps = MAX(2, numberOfSteps);
 
-	NSMutableArray *colors = [[NSMutableArray alloc] initWithCapacity:numberOfSteps];
-	CGFloat *steps = alloca(numberOfSteps * sizeof(CGFloat));
-	for (NSInteger i = 0; i < numberOfSteps; i++) {
-		steps[i] = (CGFloat)i / (numberOfSteps - 1);
-		UIColor *c = [MMMAnimation colorFrom:_topColor to:_bottomColor time:[MMMAnimation curvedTimeForTime:steps[i] curve:_curve]];
-		[colors addObject:(id)c.CGColor];
+	// Resolving the colors every time as they might depend on the current trait collection.
+	simd_float4 top, bottom;
+	if (!MMMVerticalGradientViewComponents(_topColor, &top) || !MMMVerticalGradientViewComponents(_bottomColor, &bottom)) {
+		NSAssert(NO, @"%@: both colors should be either RGB or grayscale", self.class);
+		return;
 	}
 
-	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-	CGGradientRef gradient = CGGradientCreateWithColors(colorSpace, (__bridge CFArrayRef)colors, steps);
-	CGColorSpaceRelease(colorSpace);
+	CGGradientRef gradient = MMMVerticalGradientViewCreateGradient(top, bottom, _curve, numberOfSteps);
 
 	CGContextDrawLinearGradient(
 		c,
@@ -0,0 +1,65 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+@import UIKit;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef UIView * _Nonnull (^MMMViewReusePoolFactory)(void);
+
+/**
+ * Keeps views that are expensive to build (like the ones wrapped by `MMMViewWrappingCell`) around
+ * when they are not displayed, so they can be reused for other content of the same kind.
+ *
+ * Views are pooled by their class and a "shape", a string describing the part of the configuration that
+ * would require to rebuild the view (e.g. a different set of subviews). Views of the same class and shape
+ * are interchangeable and are expected to be fully reconfigured after dequeueing.
+ *
+ * The number of idle views kept per class and shape is capped, views enqueued above it are dropped.
+ * All idle views are dropped on memory warnings.
+ */
+@interface MMMViewReusePool : NSObject
+
+/** The pool keeps no more than `maxIdleViews` views per class and shape. */
+- (id)initWithMaxIdleViews:(NSInteger)maxIdleViews NS_DESIGNATED_INITIALIZER;
+
+/** A pool keeping up to 16 idle views per class and shape. */
+- (id)init;
+
+@property (nonatomic, readonly) NSInteger maxIdleViews;
+
+/** Tells how to create views of the given class and shape when there are no idle ones. */
+- (void)registerClass:(Class)viewClass shape:(NSString *)shape factory:(MMMViewReusePoolFactory)factory
+	NS_SWIFT_NAME(register(_:shape:factory:));
+
+/** An idle view of the given class and shape or a new one made by the corresponding factory. */
+- (__kindof UIView *)dequeueViewOfClass:(Class)viewClass shape:(NSString *)shape NS_SWIFT_NAME(dequeueView(of:shape:));
+
+/** Removes the view from its superview and keeps it for reuse unless there are enough idle views already. */
+- (void)enqueueView:(UIView *)view shape:(NSString *)shape NS_SWIFT_NAME(enqueue(_:shape:));
+
+/** Makes sure there are at least `count` idle views (but no more than `maxIdleViews`) of the given class and shape. */
+- (void)prewarmClass:(Class)viewClass shape:(NSString *)shape count:(NSInteger)count
+	NS_SWIFT_NAME(prewarm(_:shape:count:));
+
+/** The number of idle views of the given class and shape. */
+- (NSInteger)numberOfIdleViewsOfClass:(Class)viewClass shape:(NSString *)shape
+	NS_SWIFT_NAME(numberOfIdleViews(of:shape:));
+
+/** Drops all idle views. */
+- (void)removeAllIdleViews;
+
+/** The number of views created via factories, including prewarming. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfCreatedViews;
+
+/** The number of views returned from the pool instead of being created. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfReusedViews;
+
+/** The number of views dropped when enqueued because of the cap. For diagnostics only. */
+@property (nonatomic, readonly) NSInteger numberOfDroppedViews;
+
+@end
+
+NS_ASSUME_NONNULL_END
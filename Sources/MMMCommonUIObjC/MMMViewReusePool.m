@@ -0,0 +1,135 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+#import "MMMViewReusePool.h"
+
+/// Views of the same class and shape.
+@interface MMMViewReusePoolBucket : NSObject {
+	@public
+	MMMViewReusePoolFactory _factory;
+	NSMutableArray<UIView *> *_idleViews;
+}
+@end
+
+@implementation MMMViewReusePoolBucket
+@end
+
+@implementation MMMViewReusePool {
+	NSMutableDictionary<NSString *, MMMViewReusePoolBucket *> *_buckets;
+	// The class each view was made for, as factories can return subclasses of the registered class.
+	NSMapTable<UIView *, Class> *_registeredClasses;
+}
+
+- (id)initWithMaxIdleViews:(NSInteger)maxIdleViews {
+
+	if (self = [super init]) {
+
+		NSAssert(maxIdleViews >= 0, @"");
+		_maxIdleViews = maxIdleViews;
+
+		_buckets = [[NSMutableDictionary alloc] init];
+		_registeredClasses = [NSMapTable weakToStrongObjectsMapTable];
+
+		[[NSNotificationCenter defaultCenter]
+			addObserver:self
+			selector:@selector(didReceiveMemoryWarning:)
+			name:UIApplicationDidReceiveMemoryWarningNotification
+			object:nil
+		];
+	}
+
+	return self;
+}
+
+- (id)init {
+	return [self initWithMaxIdleViews:16];
+}
+
+- (void)dealloc {
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)didReceiveMemoryWarning:(NSNotification *)notification {
+	[self removeAllIdleViews];
+}
+
+static inline NSString *MMMViewReusePoolKey(Class viewClass, NSString *shape) {
+	return [NSString stringWithFormat:@"%@:%@", NSStringFromClass(viewClass), shape];
+}
+
+- (MMMViewReusePoolBucket *)bucketForClass:(Class)viewClass shape:(NSString *)shape createIfNeeded:(BOOL)createIfNeeded {
+	NSString *key = MMMViewReusePoolKey(viewClass, shape);
+	MMMViewReusePoolBucket *bucket = _buckets[key];
+	if (!bucket && createIfNeeded) {
+		bucket = [[MMMViewReusePoolBucket alloc] init];
+		bucket->_idleViews = [[NSMutableArray alloc] init];
+		_buckets[key] = bucket;
+	}
+	return bucket;
+}
+
+- (void)registerClass:(Class)viewClass shape:(NSString *)shape factory:(MMMViewReusePoolFactory)factory {
+	[self bucketForClass:viewClass shape:shape createIfNeeded:YES]->_factory = [factory copy];
+}
+
+- (UIView *)makeViewForBucket:(MMMViewReusePoolBucket *)bucket viewClass:(Class)viewClass {
+	NSAssert(bucket->_factory != nil, @"No factory registered for %@", viewClass);
+	UIView *view = bucket->_factory();
+	NSAssert([view isKindOfClass:viewClass], @"The factory for %@ has returned %@", viewClass, view.class);
+	[_registeredClasses setObject:viewClass forKey:view];
+	_numberOfCreatedViews++;
+	return view;
+}
+
+- (UIView *)dequeueViewOfClass:(Class)viewClass shape:(NSString *)shape {
+
+	MMMViewReusePoolBucket *bucket = [self bucketForClass:viewClass shape:shape createIfNeeded:YES];
+
+	UIView *view = bucket->_idleViews.lastObject;
+	if (view) {
+		[bucket->_idleViews removeLastObject];
+		_numberOfReusedViews++;
+		return view;
+	}
+
+	return [self makeViewForBucket:bucket viewClass:viewClass];
+}
+
+- (void)enqueueView:(UIView *)view shape:(NSString *)shape {
+
+	[view removeFromSuperview];
+
+	// Going back to the bucket the view was dequeued from, even if the factory has made a subclass.
+	Class viewClass = [_registeredClasses objectForKey:view] ?: view.class;
+	MMMViewReusePoolBucket *bucket = [self bucketForClass:viewClass shape:shape createIfNeeded:YES];
+	if (bucket->_idleViews.count >= _maxIdleViews) {
+		_numberOfDroppedViews++;
+		return;
+	}
+
+	NSAssert(![bucket->_idleViews containsObject:view], @"%@ is enqueued twice", view);
+	[bucket->_idleViews addObject:view];
+}
+
+- (void)prewarmClass:(Class)viewClass shape:(NSString *)shape count:(NSInteger)count {
+	MMMViewReusePoolBucket *bucket = [self bucketForClass:viewClass shape:shape createIfNeeded:YES];
+	NSInteger target = MIN(count, _maxIdleViews);
+	while (bucket->_idleViews.count < target) {
+		[bucket->_idleViews addObject:[self makeViewForBucket:bucket viewClass:viewClass]];
+	}
+}
+
+- (NSInteger)numberOfIdleViewsOfClass:(Class)viewClass shape:(NSString *)shape {
+	MMMViewReusePoolBucket *bucket = [self bucketForClass:viewClass shape:shape createIfNeeded:NO];
+	return bucket ? bucket->_idleViews.count : 0;
+}
+
+- (void)removeAllIdleViews {
+	for (MMMViewReusePoolBucket *bucket in _buckets.objectEnumerator) {
+		[bucket->_idleViews removeAllObjects];
+	}
+}
+
+@end
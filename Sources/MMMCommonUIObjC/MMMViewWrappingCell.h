@@ -23,6 +23,15 @@ NS_ASSUME_NONNULL_BEGIN
 - (id)initWithView:(ViewType)view reuseIdentifier:(NSString *)reuseIdentifier;
 - (id)initWithView:(ViewType)view reuseIdentifier:(NSString *)reuseIdentifier inset:(UIEdgeInsets)inset;
 
+/**
+ * Replaces the wrapped view with the given one, returning the previous one, e.g. to put it back into
+ * an `MMMViewReusePool` when the cell is reused for content of a different kind.
+ *
+ * Only the constraints attaching the view to the edges of the `contentView` are replaced, the constraints
+ * within the views themselves are kept, so swapping a view built before is cheap.
+ */
+- (ViewType)swapWrappedView:(ViewType)view;
+
 - (id)initWithReuseIdentifier:(NSString *)reuseIdentifier NS_UNAVAILABLE;
 
 @end
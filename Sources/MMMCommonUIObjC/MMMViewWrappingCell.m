@@ -7,7 +7,10 @@
 
 #import "MMMLayout.h"
 
-@implementation MMMViewWrappingCell
+@implementation MMMViewWrappingCell {
+	UIEdgeInsets _inset;
+	NSArray<NSLayoutConstraint *> *_edgeConstraints;
+}
 
 - (id)initWithView:(UIView *)view reuseIdentifier:(NSString *)reuseIdentifier inset:(UIEdgeInsets)inset {
 
@@ -20,24 +23,47 @@
 		self.opaque = view.opaque;
 		self.backgroundColor = view.backgroundColor;
 
-		_wrappedView = view;
-		[(UIView *)_wrappedView setTranslatesAutoresizingMaskIntoConstraints:NO];
-		[self.contentView addSubview:_wrappedView];
+		_inset = inset;
 
 		[self.contentView mmm_setHuggingHorizontal:UILayoutPriorityDefaultLow vertical:UILayoutPriorityRequired];
 		[self.contentView mmm_setCompressionResistanceHorizontal:UILayoutPriorityDefaultLow vertical:UILayoutPriorityRequired];
 
-		[self.contentView
-			mmm_addConstraintsAligningView:_wrappedView
-			horizontally:MMMLayoutHorizontalAlignmentFill
-			vertically:MMMLayoutVerticalAlignmentFill
-			insets:inset
-		];
+		[self wrapView:view];
 	}
 
 	return self;
 }
 
+- (void)wrapView:(UIView *)view {
+
+	_wrappedView = view;
+	[(UIView *)_wrappedView setTranslatesAutoresizingMaskIntoConstraints:NO];
+	[self.contentView addSubview:_wrappedView];
+
+	_edgeConstraints = [self.contentView
+		mmm_addConstraintsAligningView:_wrappedView
+		horizontally:MMMLayoutHorizontalAlignmentFill
+		vertically:MMMLayoutVerticalAlignmentFill
+		insets:_inset
+	];
+}
+
+- (UIView *)swapWrappedView:(UIView *)view {
+
+	NSAssert([view isKindOfClass:[UIView class]], @"");
+
+	UIView *oldView = _wrappedView;
+	if (view == oldView)
+		return oldView;
+
+	[NSLayoutConstraint deactivateConstraints:_edgeConstraints];
+	[oldView removeFromSuperview];
+
+	[self wrapView:view];
+
+	return oldView;
+}
+
 - (id)initWithView:(UIView *)view reuseIdentifier:(NSString *)reuseIdentifier {
 	return [self initWithView:view reuseIdentifier:reuseIdentifier inset:UIEdgeInsetsZero];
 }
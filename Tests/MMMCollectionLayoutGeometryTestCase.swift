@@ -0,0 +1,118 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMCollectionLayoutGeometryTestCase: XCTestCase {
+
+	private func makeGeometry(_ arrangement: MMMCollectionLayoutGeometry.Arrangement) -> MMMCollectionLayoutGeometry {
+		return MMMCollectionLayoutGeometry(
+			arrangement: arrangement,
+			width: 330,
+			sectionInsets: UIEdgeInsets(top: 10, left: 10, bottom: 20, right: 10),
+			itemSpacing: 10,
+			lineSpacing: 5
+		)
+	}
+
+	private func randomHeights(sections: Int, items: Int) -> [[CGFloat]] {
+		return (0..<sections).map { _ in (0..<items).map { _ in CGFloat(Int.random(in: 10...200)) } }
+	}
+
+	private func allFrames(_ g: MMMCollectionLayoutGeometry) -> [CGRect] {
+		return (0..<g.numberOfSections).flatMap { s in (0..<g.numberOfItems(inSection: s)).map { g.frame(section: s, item: $0) } }
+	}
+
+	public func testArrangements() {
+
+		let list = makeGeometry(.list)
+		list.setHeights([[10, 20], [30]])
+		XCTAssertEqual(list.itemWidth, 310)
+		XCTAssertEqual(list.frame(section: 0, item: 1), CGRect(x: 10, y: 25, width: 310, height: 20))
+		// The second section starts after the bottom inset of the first one.
+		XCTAssertEqual(list.frame(section: 1, item: 0), CGRect(x: 10, y: 75, width: 310, height: 30))
+		XCTAssertEqual(list.contentHeight, 125)
+
+		let grid = makeGeometry(.grid(columns: 3))
+		grid.setHeights([[10, 40, 20, 30]])
+		XCTAssertEqual(grid.itemWidth, 96.666, accuracy: 0.001)
+		XCTAssertEqual(grid.frame(section: 0, item: 2).height, 40)
+		XCTAssertEqual(grid.frame(section: 0, item: 3).minY, 55)
+		XCTAssertEqual(grid.frame(section: 0, item: 3).minX, 10)
+
+		let masonry = makeGeometry(.masonry(columns: 2))
+		masonry.setHeights([[100, 10, 10, 10]])
+		// The 3rd and the 4th items go into the second, shorter column.
+		XCTAssertEqual(masonry.frame(section: 0, item: 2), CGRect(x: 170, y: 25, width: 150, height: 10))
+		XCTAssertEqual(masonry.frame(section: 0, item: 3).minY, 40)
+		XCTAssertEqual(masonry.contentHeight, 130)
+	}
+
+	public func testQueries() {
+		for arrangement: MMMCollectionLayoutGeometry.Arrangement in [.list, .grid(columns: 3), .masonry(columns: 3)] {
+			let g = makeGeometry(arrangement)
+			g.setHeights(randomHeights(sections: 4, items: 50))
+			let frames = allFrames(g)
+			for _ in 0..<100 {
+				let rect = CGRect(x: 0, y: CGFloat.random(in: -100...g.contentHeight), width: 330, height: CGFloat.random(in: 0...600))
+				var found: [CGRect] = []
+				g.forEachItem(in: rect) { _, _, frame in found.append(frame) }
+				XCTAssertEqual(found, frames.filter { $0.intersects(rect) }, "\(arrangement)")
+			}
+		}
+	}
+
+	public func testIncremental() {
+		for arrangement: MMMCollectionLayoutGeometry.Arrangement in [.list, .grid(columns: 3), .masonry(columns: 3)] {
+
+			var heights = randomHeights(sections: 3, items: 40)
+
+			let incremental = makeGeometry(arrangement)
+			incremental.setHeights(heights)
+
+			// Appending to the last section.
+			let appended = (0..<17).map { _ in CGFloat(Int.random(in: 10...200)) }
+			incremental.appendHeights(appended)
+			heights[2].append(contentsOf: appended)
+
+			// Resizing a couple of items.
+			incremental.setHeights([(section: 1, item: 7, height: 333), (section: 0, item: 39, height: 1)])
+			heights[1][7] = 333
+			heights[0][39] = 1
+
+			let full = makeGeometry(arrangement)
+			full.setHeights(heights)
+
+			XCTAssertEqual(allFrames(incremental), allFrames(full), "\(arrangement)")
+			XCTAssertEqual(incremental.contentHeight, full.contentHeight)
+
+			var a: [CGRect] = [], b: [CGRect] = []
+			let rect = CGRect(x: 0, y: 1000, width: 330, height: 700)
+			incremental.forEachItem(in: rect) { _, _, frame in a.append(frame) }
+			full.forEachItem(in: rect) { _, _, frame in b.append(frame) }
+			XCTAssertEqual(a, b)
+		}
+	}
+
+	private func measureMillionItems(_ arrangement: MMMCollectionLayoutGeometry.Arrangement) {
+		let heights = [(0..<1_000_000).map { CGFloat(40 + ($0 * 7919) % 160) }]
+		let g = makeGeometry(arrangement)
+		measure {
+			g.setHeights(heights)
+			var count = 0
+			for i in 0..<1000 {
+				g.forEachItem(in: CGRect(x: 0, y: g.contentHeight * CGFloat(i) / 1000, width: 330, height: 800)) { _, _, _ in
+					count += 1
+				}
+			}
+			XCTAssertGreaterThan(count, 0)
+		}
+	}
+
+	public func testPerformanceList() { measureMillionItems(.list) }
+	public func testPerformanceGrid() { measureMillionItems(.grid(columns: 3)) }
+	public func testPerformanceMasonry() { measureMillionItems(.masonry(columns: 3)) }
+}
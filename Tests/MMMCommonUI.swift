@@ -8,3 +8,50 @@ import XCTest
 
 class MMMCommonUITestCase: XCTestCase {
 }
+
+extension XCTestCase {
+
+	/// A solid image of the given size in points, with the scale of 1 by default, so the size is in pixels as well.
+	func makeImage(width: CGFloat, height: CGFloat, scale: CGFloat = 1) -> UIImage {
+		let format = UIGraphicsImageRendererFormat()
+		format.scale = scale
+		return UIGraphicsImageRenderer(size: CGSize(width: width, height: height), format: format).image { context in
+			UIColor.gray.setFill()
+			context.fill(CGRect(x: 0, y: 0, width: width, height: height))
+		}
+	}
+}
+
+/// An image request performer remembering the requests, so tests can complete them when needed.
+class MMMFakeImageRequestPerformer: NSObject, MMMImageRequestPerformer {
+
+	class Request {
+		let key: MMMDecodedImageCacheKey
+		let progress: MMMImageRequestProgress?
+		let completion: MMMImageRequestCompletion
+		var cancelled = false
+		init(key: MMMDecodedImageCacheKey, progress: MMMImageRequestProgress?, completion: @escaping MMMImageRequestCompletion) {
+			self.key = key
+			self.progress = progress
+			self.completion = completion
+		}
+	}
+
+	var requests = [Request]()
+
+	var running: [Request] { return requests.filter { !$0.cancelled } }
+
+	func startImageRequest(
+		for key: MMMDecodedImageCacheKey,
+		progress: MMMImageRequestProgress?,
+		completion: @escaping MMMImageRequestCompletion
+	) -> Any {
+		let r = Request(key: key, progress: progress, completion: completion)
+		requests.append(r)
+		return r
+	}
+
+	func cancelImageRequest(_ request: Any) {
+		(request as! Request).cancelled = true
+	}
+}
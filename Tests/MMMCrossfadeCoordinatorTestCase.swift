@@ -0,0 +1,71 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMCrossfadeCoordinatorTestCase: XCTestCase {
+
+	public func testPolicy() {
+
+		let policy = MMMCrossfadePolicy()
+
+		// Full duration when not scrolling or scrolling slowly, regardless of the direction.
+		XCTAssertEqual(policy.duration(velocity: 0, isVisible: true, activeCrossfades: 0), policy.duration)
+		XCTAssertEqual(policy.duration(velocity: -policy.slowVelocity, isVisible: true, activeCrossfades: 0), policy.duration)
+
+		// Shorter in between.
+		let middle = policy.duration(
+			velocity: (policy.slowVelocity + policy.fastVelocity) / 2,
+			isVisible: true,
+			activeCrossfades: 0
+		)
+		XCTAssertEqual(middle, policy.duration / 2, accuracy: 1e-6)
+
+		// Skipped when too short to be noticed or when scrolling fast.
+		XCTAssertEqual(policy.duration(velocity: policy.fastVelocity - 1, isVisible: true, activeCrossfades: 0), 0)
+		XCTAssertEqual(policy.duration(velocity: policy.fastVelocity * 2, isVisible: true, activeCrossfades: 0), 0)
+
+		// Skipped when not visible or over budget.
+		XCTAssertEqual(policy.duration(velocity: 0, isVisible: false, activeCrossfades: 0), 0)
+		XCTAssertEqual(policy.duration(velocity: 0, isVisible: true, activeCrossfades: policy.maxConcurrentCrossfades), 0)
+		XCTAssertEqual(
+			policy.duration(velocity: 0, isVisible: true, activeCrossfades: policy.maxConcurrentCrossfades - 1),
+			policy.duration
+		)
+	}
+
+	public func testBudget() {
+
+		var policy = MMMCrossfadePolicy()
+		policy.maxConcurrentCrossfades = 2
+		let coordinator = MMMCrossfadeCoordinator(policy: policy)
+
+		let window = UIWindow(frame: CGRect(x: 0, y: 0, width: 320, height: 640))
+		window.isHidden = false
+
+		let image = UIGraphicsImageRenderer(size: CGSize(width: 4, height: 4)).image { _ in }
+		let views = (0..<5).map { i -> UIImageView in
+			let view = UIImageView(frame: CGRect(x: 0, y: CGFloat(i) * 50, width: 40, height: 40))
+			window.addSubview(view)
+			return view
+		}
+		views.forEach { coordinator.setImage(image, on: $0) }
+
+		// Every view gets its image right away, but only the first two crossfade.
+		XCTAssert(views.allSatisfy { $0.image === image })
+		XCTAssertEqual(coordinator.numberOfCrossfades, 2)
+		XCTAssertEqual(coordinator.numberOfSkippedCrossfades, 3)
+
+		// Off screen ones are never animated.
+		let offscreen = UIImageView(frame: CGRect(x: 0, y: 1000, width: 40, height: 40))
+		window.addSubview(offscreen)
+		let done = expectation(for: NSPredicate { _, _ in coordinator.numberOfActiveCrossfades == 0 }, evaluatedWith: nil)
+		wait(for: [done], timeout: 2)
+		coordinator.setImage(image, on: offscreen)
+		XCTAssertEqual(coordinator.numberOfCrossfades, 2)
+		XCTAssertEqual(coordinator.numberOfSkippedCrossfades, 4)
+	}
+}
@@ -0,0 +1,87 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMDecodedImageCacheTestCase: XCTestCase {
+
+	private func key(_ id: String, _ size: CGFloat = 10) -> MMMDecodedImageCacheKey {
+		return MMMDecodedImageCacheKey(sourceIdentifier: id, pixelSize: CGSize(width: size, height: size), contentMode: 0)
+	}
+
+	public func testKeys() {
+		XCTAssertEqual(key("a", 10), key("a", 10.2))
+		XCTAssertEqual(key("a", 10).hash, key("a", 10.2).hash)
+		XCTAssertNotEqual(key("a", 10), key("a", 11))
+		XCTAssertNotEqual(key("a"), key("b"))
+		XCTAssertNotEqual(
+			key("a"),
+			MMMDecodedImageCacheKey(sourceIdentifier: "a", pixelSize: CGSize(width: 10, height: 10), contentMode: 1)
+		)
+	}
+
+	public func testLRU() {
+
+		let img = makeImage(width: 10, height: 10)
+		let cost = MMMDecodedImageCache.cost(for: img)
+		XCTAssertGreaterThanOrEqual(cost, 10 * 10 * 4)
+
+		let cache = MMMDecodedImageCache(totalCostLimit: cost * 3)
+
+		XCTAssertNil(cache.image(for: key("a")))
+		XCTAssertEqual(cache.numberOfMisses, 1)
+
+		cache.setImage(img, for: key("a"))
+		cache.setImage(img, for: key("b"))
+		cache.setImage(img, for: key("c"))
+		XCTAssertEqual(cache.count, 3)
+		XCTAssertEqual(cache.totalCost, cost * 3)
+
+		// Touching "a", so "b" becomes the least recently used one.
+		XCTAssert(cache.image(for: key("a")) === img)
+		XCTAssertEqual(cache.numberOfHits, 1)
+
+		cache.setImage(img, for: key("d"))
+		XCTAssertEqual(cache.count, 3)
+		XCTAssertEqual(cache.numberOfEvictions, 1)
+		XCTAssertNil(cache.image(for: key("b")))
+		XCTAssertNotNil(cache.image(for: key("a")))
+
+		// Replacing does not count twice.
+		cache.setImage(img, for: key("d"))
+		XCTAssertEqual(cache.totalCost, cost * 3)
+
+		// Too large to be stored at all.
+		cache.setImage(makeImage(width: 100, height: 100), for: key("e"))
+		XCTAssertNil(cache.image(for: key("e")))
+		XCTAssertEqual(cache.count, 3)
+
+		cache.totalCostLimit = cost
+		XCTAssertEqual(cache.count, 1)
+
+		cache.removeAllImages()
+		XCTAssertEqual(cache.count, 0)
+		XCTAssertEqual(cache.totalCost, 0)
+	}
+
+	public func testMemoryPressure() {
+
+		let img = makeImage(width: 10, height: 10)
+		let cost = MMMDecodedImageCache.cost(for: img)
+		let cache = MMMDecodedImageCache(totalCostLimit: cost * 4)
+		for id in ["a", "b", "c", "d"] {
+			cache.setImage(img, for: key(id))
+		}
+
+		cache.handleMemoryPressureCritical(false)
+		XCTAssertEqual(cache.count, 2)
+		XCTAssertNotNil(cache.image(for: key("d")))
+
+		NotificationCenter.default.post(name: UIApplication.didReceiveMemoryWarningNotification, object: nil)
+		XCTAssertEqual(cache.count, 0)
+		XCTAssertEqual(cache.numberOfEvictions, 4)
+	}
+}
@@ -0,0 +1,100 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+import simd
+
+class MMMGradientRasterizerTestCase: XCTestCase {
+
+	private func ramp(from: simd_float4, to: simd_float4, count: Int = 16, curve: MMMAnimationCurve = .linear) -> [simd_float4] {
+		var ramp = [simd_float4](repeating: simd_float4(), count: count)
+		MMMGradientRampFill(&ramp, count, from, to, curve)
+		return ramp
+	}
+
+	public func testRampFill() {
+		let r = ramp(from: simd_float4(0, 0, 0, 0), to: simd_float4(1, 1, 1, 1), count: 5, curve: .easeIn)
+		XCTAssertEqual(r.first, simd_float4(0, 0, 0, 0))
+		XCTAssertEqual(r.last, simd_float4(1, 1, 1, 1))
+		// Ease in: slower in the beginning.
+		XCTAssertLessThan(r[2].x, 0.5)
+	}
+
+	public func testLinearGradient() {
+
+		let width = 8, height = 64
+		var pixels = [UInt8](repeating: 0xAA, count: width * height * 4)
+		let r = ramp(from: simd_float4(1, 0, 0, 1), to: simd_float4(0, 0, 1, 0.5))
+		MMMGradientRasterizeLinear(&pixels, width, height, width * 4, r, r.count, simd_float2(0, 0), simd_float2(0, Float(height)))
+
+		func pixel(_ x: Int, _ y: Int) -> [Int] { (0..<4).map { Int(pixels[(y * width + x) * 4 + $0]) } }
+
+		// Premultiplied ends within the dithering error.
+		XCTAssertLessThanOrEqual(abs(pixel(0, 0)[0] - 255), 5)
+		XCTAssertLessThanOrEqual(abs(pixel(0, 0)[3] - 255), 2)
+		XCTAssertLessThanOrEqual(abs(pixel(0, height - 1)[2] - 128), 3)
+		XCTAssertLessThanOrEqual(abs(pixel(0, height - 1)[3] - 128), 3)
+
+		for y in 0..<height {
+			for x in 0..<width {
+				let p = pixel(x, y)
+				// Never breaking premultiplication.
+				XCTAssert(p[0] <= p[3] && p[1] <= p[3] && p[2] <= p[3])
+				// Vertical gradient: pixels within a row can differ by dithering only.
+				XCTAssertLessThanOrEqual(abs(p[3] - pixel(0, y)[3]), 1)
+			}
+		}
+	}
+
+	/// The radial gradient with a shadow ramp should match the reference shadow rasterizer (our "golden" image).
+	public func testRadialGradientMatchesShadowReference() {
+
+		let width = 192, height = 30
+		let shadowAlpha: CGFloat = 0.3, curvature: CGFloat = 0.5
+
+		var reference = [UInt8](repeating: 0, count: width * height * 4)
+		MMMScrollViewShadowRasterize(&reference, width, height, width * 4, .top, shadowAlpha, curvature)
+
+		// Opacity along the gradient sampled from the reference itself: the column in the middle goes through
+		// the whole ramp.
+		let d = CGFloat(width) / 2
+		let h = CGFloat(height) * curvature
+		let radius = (d * d + h * h) / (2 * h)
+		let r: [simd_float4] = (0..<64).map { i in
+			let t = CGFloat(i) / 63
+			let opacity = MMMScrollViewShadowOpacity(CGPoint(x: d, y: t * CGFloat(height)), CGSize(width: width, height: height), shadowAlpha, curvature)
+			return simd_float4(0, 0, 0, Float(opacity))
+		}
+
+		var pixels = [UInt8](repeating: 0xAA, count: width * height * 4)
+		MMMGradientRasterizeRadial(
+			&pixels, width, height, width * 4, r, r.count,
+			simd_float2(Float(d), Float(CGFloat(height) - radius)), Float(radius - CGFloat(height)), Float(radius)
+		)
+
+		for i in stride(from: 0, to: pixels.count, by: 4) {
+			XCTAssertLessThanOrEqual(abs(Int(pixels[i + 3]) - Int(reference[i + 3])), 2)
+		}
+	}
+
+	public func testLinearPerformance() {
+		let width = 1024, height = 1024
+		var pixels = [UInt8](repeating: 0, count: width * height * 4)
+		let r = ramp(from: simd_float4(0, 0, 0, 1), to: simd_float4(1, 1, 1, 0), count: 50, curve: .easeInOut)
+		measure {
+			MMMGradientRasterizeLinear(&pixels, width, height, width * 4, r, r.count, simd_float2(0, 0), simd_float2(0, Float(height)))
+		}
+	}
+
+	public func testRadialPerformance() {
+		let width = 1024, height = 1024
+		var pixels = [UInt8](repeating: 0, count: width * height * 4)
+		let r = ramp(from: simd_float4(0, 0, 0, 0.3), to: simd_float4(0, 0, 0, 0), count: 32, curve: .softerEaseOut)
+		measure {
+			MMMGradientRasterizeRadial(&pixels, width, height, width * 4, r, r.count, simd_float2(512, -2000), 2000, 3024)
+		}
+	}
+}
@@ -0,0 +1,80 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMImageDecoderTestCase: XCTestCase {
+
+	public func testDownsampling() {
+
+		let source = makeImage(width: 400, height: 200, scale: 2)
+
+		// Fit: limited by the width.
+		let fit = MMMImageDecoderDecodedImage(source, CGSize(width: 100, height: 100), .fit)
+		XCTAssertEqual(fit.cgImage?.width, 100)
+		XCTAssertEqual(fit.cgImage?.height, 50)
+		// The size in points is preserved.
+		XCTAssertEqual(fit.size.width, 400, accuracy: 0.01)
+		XCTAssertEqual(fit.size.height, 200, accuracy: 0.01)
+
+		// Fill: limited by the height.
+		let fill = MMMImageDecoderDecodedImage(source, CGSize(width: 100, height: 100), .fill)
+		XCTAssertEqual(fill.cgImage?.width, 200)
+		XCTAssertEqual(fill.cgImage?.height, 100)
+
+		// Never upsampling.
+		let large = MMMImageDecoderDecodedImage(source, CGSize(width: 10000, height: 10000), .fit)
+		XCTAssertEqual(large.cgImage?.width, 800)
+
+		// Zero size means decoding only.
+		let decoded = MMMImageDecoderDecodedImage(source, .zero, .fit)
+		XCTAssertEqual(decoded.cgImage?.width, 800)
+		XCTAssertEqual(decoded.cgImage?.height, 400)
+	}
+
+	public func testBackPressureAndCancellation() {
+
+		let decoder = MMMImageDecoder(maxConcurrentDecodes: 1, maxPendingDecodes: 2)
+		// Large enough for the first request to be still running while the rest are added.
+		let source = makeImage(width: 2000, height: 2000)
+
+		var completed = [Int: UIImage]()
+		let done = expectation(description: "All requests are done")
+		done.expectedFulfillmentCount = 5
+
+		var requests = [MMMImageDecoderRequest]()
+		for i in 0..<6 {
+			requests.append(decoder.decodeImage(source, pixelSize: CGSize(width: 50, height: 50), contentMode: .fit) { image in
+				completed[i] = image
+				done.fulfill()
+			})
+		}
+		// The first one is running, 1, 2 and 3 are skipped, 4 and 5 are pending.
+		XCTAssertEqual(decoder.numberOfSkippedDecodes, 3)
+		XCTAssertEqual(decoder.numberOfPendingDecodes, 2)
+		requests[5].cancel()
+		XCTAssertEqual(decoder.numberOfPendingDecodes, 1)
+
+		wait(for: [done], timeout: 10)
+
+		XCTAssertNil(completed[5])
+		// Skipped ones are returned as is.
+		XCTAssert(completed[1] === source)
+		XCTAssertEqual(completed[0]?.cgImage?.width, 50)
+		XCTAssertEqual(completed[4]?.cgImage?.width, 50)
+		XCTAssertEqual(decoder.numberOfDecodedImages, 2)
+		XCTAssertEqual(decoder.numberOfPendingDecodes, 0)
+	}
+
+	public func testPerformance() {
+		let source = makeImage(width: 1200, height: 900)
+		measure {
+			for _ in 0..<10 {
+				_ = MMMImageDecoderDecodedImage(source, CGSize(width: 180, height: 180), .fill)
+			}
+		}
+	}
+}
@@ -0,0 +1,141 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMImageRequestCoalescerTestCase: XCTestCase {
+
+	private func key(_ id: String) -> MMMDecodedImageCacheKey {
+		return MMMDecodedImageCacheKey(sourceIdentifier: id, pixelSize: CGSize(width: 100, height: 100), contentMode: 0)
+	}
+
+	/// Completions are delivered asynchronously on the main queue.
+	private func flushMainQueue() {
+		let e = expectation(description: "Main queue")
+		DispatchQueue.main.async { e.fulfill() }
+		wait(for: [e], timeout: 1)
+	}
+
+	public func testCoalescing() {
+
+		let performer = MMMFakeImageRequestPerformer()
+		let coalescer = MMMImageRequestCoalescer(performer: performer, maxConcurrentRequests: 2)
+
+		var results = [String]()
+		let a1 = coalescer.requestImage(for: key("a")) { _, _ in results.append("a1") }
+		_ = coalescer.requestImage(for: key("a")) { _, _ in results.append("a2") }
+		XCTAssertEqual(performer.requests.count, 1)
+		XCTAssertEqual(coalescer.numberOfCoalescedRequests, 1)
+
+		// One of the clients is gone, but the other one still needs the image.
+		a1.cancel()
+		XCTAssertEqual(performer.running.count, 1)
+
+		let image = UIImage()
+		performer.requests[0].completion(image, nil)
+		flushMainQueue()
+		XCTAssertEqual(results, ["a2"])
+		XCTAssertEqual(coalescer.numberOfRequestsInFlight, 0)
+
+		// A new request after the previous one has finished is a new one.
+		_ = coalescer.requestImage(for: key("a")) { _, _ in }
+		XCTAssertEqual(performer.requests.count, 2)
+	}
+
+	public func testConcurrencyAndCancellation() {
+
+		let performer = MMMFakeImageRequestPerformer()
+		let coalescer = MMMImageRequestCoalescer(performer: performer, maxConcurrentRequests: 2)
+
+		var results = [String]()
+		let a = coalescer.requestImage(for: key("a")) { _, _ in results.append("a") }
+		_ = coalescer.requestImage(for: key("b")) { _, _ in results.append("b") }
+		let c = coalescer.requestImage(for: key("c")) { _, _ in results.append("c") }
+		_ = coalescer.requestImage(for: key("d")) { _, _ in results.append("d") }
+
+		// Only 2 can run at the same time.
+		XCTAssertEqual(performer.requests.map { $0.key.sourceIdentifier }, ["a", "b"])
+		XCTAssertEqual(coalescer.numberOfRequestsInFlight, 4)
+
+		// Cancelling a waiting one simply drops it.
+		c.cancel()
+		XCTAssertEqual(performer.requests.count, 2)
+
+		// Cancelling a running one cancels the actual request and lets the next one start.
+		a.cancel()
+		XCTAssert(performer.requests[0].cancelled)
+		XCTAssertEqual(performer.running.map { $0.key.sourceIdentifier }, ["b", "d"])
+		XCTAssertEqual(coalescer.numberOfCancelledRequests, 2)
+
+		// Late completions of the cancelled requests are ignored.
+		performer.requests[0].completion(UIImage(), nil)
+		performer.requests[1].completion(nil, NSError(domain: "Test", code: 1))
+		flushMainQueue()
+		XCTAssertEqual(results, ["b"])
+		XCTAssertEqual(coalescer.numberOfStartedRequests, 3)
+		XCTAssertEqual(coalescer.numberOfRequestsInFlight, 1)
+	}
+
+	public func testProgressiveDelivery() {
+
+		let delivery = MMMProgressiveImageDelivery()
+		let low = UIImage()
+		let high = UIImage()
+		// Failures of intermediate deliveries are not final.
+		XCTAssertEqual(delivery.action(for: nil, degraded: true), .ignore)
+		XCTAssertEqual(delivery.action(for: low, degraded: true), .progress)
+		XCTAssert(delivery.hasIntermediateImage)
+		XCTAssertEqual(delivery.action(for: high, degraded: false), .complete)
+		XCTAssert(delivery.isComplete)
+		// Nothing after the final one.
+		XCTAssertEqual(delivery.action(for: low, degraded: true), .ignore)
+		XCTAssertEqual(delivery.action(for: high, degraded: false), .ignore)
+
+		// A failure without intermediate images.
+		XCTAssertEqual(MMMProgressiveImageDelivery().action(for: nil, degraded: false), .complete)
+	}
+
+	public func testProgress() {
+
+		let performer = MMMFakeImageRequestPerformer()
+		let coalescer = MMMImageRequestCoalescer(performer: performer, maxConcurrentRequests: 2)
+
+		// Not asking for progress when nobody needs it.
+		_ = coalescer.requestImage(for: key("a")) { _, _ in }
+		XCTAssertNil(performer.requests[0].progress)
+
+		var results = [String]()
+		_ = coalescer.requestImage(
+			for: key("b"),
+			progress: { _ in results.append("b1-progress") },
+			completion: { _, _ in results.append("b1") }
+		)
+		XCTAssertNotNil(performer.requests[1].progress)
+
+		let low = UIImage()
+		performer.requests[1].progress?(low)
+		flushMainQueue()
+		XCTAssertEqual(results, ["b1-progress"])
+
+		// Joining late still gets the latest intermediate image.
+		_ = coalescer.requestImage(
+			for: key("b"),
+			progress: { image in
+				XCTAssert(image === low)
+				results.append("b2-progress")
+			},
+			completion: { _, _ in results.append("b2") }
+		)
+		flushMainQueue()
+		XCTAssertEqual(results, ["b1-progress", "b2-progress"])
+
+		performer.requests[1].completion(UIImage(), nil)
+		// Late intermediate images are ignored.
+		performer.requests[1].progress?(low)
+		flushMainQueue()
+		XCTAssertEqual(results, ["b1-progress", "b2-progress", "b1", "b2"])
+	}
+}
@@ -0,0 +1,53 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMImageViewTestCase: XCTestCase {
+
+	private func image(width: CGFloat, height: CGFloat, insets: UIEdgeInsets = .zero) -> UIImage {
+		return makeImage(width: width, height: height).withAlignmentRectInsets(insets)
+	}
+
+	public func testHighlightingDoesNotChurn() {
+
+		let normal = image(width: 44, height: 24, insets: UIEdgeInsets(top: 2, left: 2, bottom: 2, right: 2))
+		let highlighted = image(width: 44, height: 24, insets: UIEdgeInsets(top: 2, left: 2, bottom: 2, right: 2))
+		let view = MMMImageView(image: normal, highlightedImage: highlighted)
+
+		let container = UIView(frame: CGRect(x: 0, y: 0, width: 200, height: 200))
+		container.addSubview(view)
+		container.layoutIfNeeded()
+		XCTAssertEqual(view.numberOfAspectRatioConstraintUpdates, 1)
+
+		let imageView = view.subviews.first as! UIImageView
+		let stripped = imageView.image
+		XCTAssertEqual(stripped?.alignmentRectInsets, .zero)
+
+		for _ in 0..<10 {
+			view.isHighlighted = true
+			container.layoutIfNeeded()
+			view.isHighlighted = false
+			container.layoutIfNeeded()
+		}
+
+		// The stripped version is reused and the constraint stays the same.
+		XCTAssert(imageView.image === stripped)
+		XCTAssertEqual(view.numberOfAspectRatioConstraintUpdates, 1)
+
+		// A different ratio does require a new constraint.
+		view.image = image(width: 24, height: 24)
+		container.layoutIfNeeded()
+		XCTAssertEqual(view.numberOfAspectRatioConstraintUpdates, 2)
+		XCTAssertEqual(view.bounds.width, view.bounds.height)
+
+		// The same ratio in a different size does not.
+		view.image = image(width: 48, height: 48)
+		container.layoutIfNeeded()
+		XCTAssertEqual(view.numberOfAspectRatioConstraintUpdates, 2)
+		XCTAssertEqual(view.numberOfAvoidedAspectRatioConstraintUpdates, 1)
+	}
+}
@@ -0,0 +1,60 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMKeyboardTestCase: XCTestCase {
+
+	public func testCurveMapping() {
+		XCTAssertEqual(MMMAnimationCurveFromViewAnimationCurve(.linear), .linear)
+		XCTAssertEqual(MMMAnimationCurveFromViewAnimationCurve(.easeIn), .easeIn)
+		XCTAssertEqual(MMMAnimationCurveFromViewAnimationCurve(.easeOut), .easeOut)
+		XCTAssertEqual(MMMAnimationCurveFromViewAnimationCurve(.easeInOut), .easeInOut)
+		// The undocumented one used by the keyboard.
+		XCTAssertEqual(MMMAnimationCurveFromViewAnimationCurve(UIView.AnimationCurve(rawValue: 7)!), .easeOutQuart)
+	}
+
+	public func testRectInterpolation() {
+		let from = CGRect(x: 0, y: 600, width: 320, height: 0)
+		let to = CGRect(x: 0, y: 300, width: 320, height: 300)
+		XCTAssertEqual(MMMAnimation.rect(from: from, to: to, time: 0), from)
+		XCTAssertEqual(MMMAnimation.rect(from: from, to: to, time: 1), to)
+		XCTAssertEqual(MMMAnimation.rect(from: from, to: to, time: 0.5), CGRect(x: 0, y: 450, width: 320, height: 150))
+	}
+
+	public func testFrameFollowsAnimation() {
+
+		let keyboard = MMMKeyboard()
+		XCTAssert(keyboard.frame.isNull)
+
+		let screen = UIScreen.main.bounds
+		let hidden = CGRect(x: 0, y: screen.maxY, width: screen.width, height: 300)
+		let visible = hidden.offsetBy(dx: 0, dy: -300)
+
+		var frames: [CGRect] = []
+		MMMAnimator.shared()._testRun(numberOfSteps: 5, animations: {
+			NotificationCenter.default.post(
+				name: UIResponder.keyboardWillShowNotification,
+				object: nil,
+				userInfo: [
+					UIResponder.keyboardFrameBeginUserInfoKey: NSValue(cgRect: hidden),
+					UIResponder.keyboardFrameEndUserInfoKey: NSValue(cgRect: visible),
+					UIResponder.keyboardAnimationDurationUserInfoKey: 0.25,
+					UIResponder.keyboardAnimationCurveUserInfoKey: 7
+				]
+			)
+		}, stepBlock: { _ in
+			frames.append(keyboard.frame)
+		})
+
+		XCTAssertEqual(keyboard.state, .visible)
+		XCTAssertEqual(frames.first, hidden)
+		XCTAssertEqual(frames.last, visible)
+		for (prev, next) in zip(frames, frames.dropFirst()) {
+			XCTAssertLessThanOrEqual(next.minY, prev.minY)
+		}
+	}
+}
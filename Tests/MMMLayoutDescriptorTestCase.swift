@@ -0,0 +1,109 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMLayoutDescriptorTestCase: XCTestCase {
+
+	/// Every character is 10x20 points, lines wrap by characters, so the results are easy to predict.
+	private final class MonospaceMeasurer: MMMTextMeasurer {
+		func size(of text: String, font: UIFont, numberOfLines: Int, width: CGFloat) -> CGSize {
+			let perLine = max(1, Int(width / 10))
+			var lines = (text.count + perLine - 1) / perLine
+			if numberOfLines > 0 {
+				lines = min(lines, numberOfLines)
+			}
+			return CGSize(width: CGFloat(min(text.count, perLine) * 10), height: CGFloat(lines * 20))
+		}
+	}
+
+	private let measurer = MonospaceMeasurer()
+	private let font = UIFont.systemFont(ofSize: 12)
+
+	private func text(_ length: Int, numberOfLines: Int = 0) -> MMMLayoutDescriptor {
+		return .text(String(repeating: "x", count: length), font: font, numberOfLines: numberOfLines)
+	}
+
+	public func testPrimitives() {
+
+		XCTAssertEqual(text(25).size(forWidth: 100, measurer: measurer), CGSize(width: 100, height: 60))
+		XCTAssertEqual(text(25, numberOfLines: 2).size(forWidth: 100, measurer: measurer).height, 40)
+		XCTAssertEqual(MMMLayoutDescriptor.aspect(heightToWidth: 0.5).size(forWidth: 100, measurer: measurer).height, 50)
+
+		let insets = UIEdgeInsets(top: 5, left: 10, bottom: 15, right: 10)
+		XCTAssertEqual(
+			MMMLayoutDescriptor.padded(text(25), insets: insets).size(forWidth: 120, measurer: measurer),
+			CGSize(width: 120, height: 80)
+		)
+
+		// 60 + 8 + 20 + 8 + 50 and the insets.
+		let vertical = MMMLayoutDescriptor.verticalStack(
+			[text(25), .fixed(CGSize(width: 20, height: 20)), .aspect(heightToWidth: 0.5)],
+			spacing: 8, insets: insets
+		)
+		XCTAssertEqual(vertical.size(forWidth: 120, measurer: measurer).height, 166)
+
+		// An icon of 40 points, then the text gets 100 - 40 - 10 = 50 points, i.e. 5 lines.
+		let horizontal = MMMLayoutDescriptor.horizontalStack(
+			[.fixed(CGSize(width: 40, height: 40)), text(25)],
+			spacing: 10, insets: .zero
+		)
+		XCTAssertEqual(horizontal.size(forWidth: 100, measurer: measurer).height, 100)
+
+		// Columns of 40 points, rows are 2 and 1 lines high.
+		let grid = MMMLayoutDescriptor.grid(
+			[text(5), text(1), text(1)], numberOfColumns: 2,
+			horizontalSpacing: 20, verticalSpacing: 10, insets: .zero
+		)
+		XCTAssertEqual(grid.size(forWidth: 100, measurer: measurer).height, 40 + 10 + 20)
+	}
+
+	private func makeDescriptors(count: Int) -> [MMMLayoutDescriptor] {
+		return (0..<count).map { i in
+			.padded(
+				.verticalStack(
+					[
+						.horizontalStack([.fixed(CGSize(width: 40, height: 40)), text(10 + i % 50)], spacing: 8, insets: .zero),
+						text(i % 200),
+						.grid((0..<(i % 7)).map { text($0 * 3) }, numberOfColumns: 3, horizontalSpacing: 4, verticalSpacing: 4, insets: .zero)
+					],
+					spacing: 6, insets: .zero
+				),
+				insets: UIEdgeInsets(top: 10, left: 16, bottom: 10, right: 16)
+			)
+		}
+	}
+
+	public func testParallelSizing() {
+
+		let descriptors = makeDescriptors(count: 333)
+		let serial = MMMBackgroundCellSizer(measurer: measurer, maxConcurrency: 1).heights(for: descriptors, width: 375)
+		let parallel = MMMBackgroundCellSizer(measurer: measurer, maxConcurrency: 8).heights(for: descriptors, width: 375)
+		XCTAssertEqual(serial, parallel)
+		XCTAssertEqual(serial[3], descriptors[3].size(forWidth: 375, measurer: measurer).height)
+
+		let e = expectation(description: "completion")
+		MMMBackgroundCellSizer(measurer: measurer).heights(for: descriptors, width: 375) { heights in
+			XCTAssert(Thread.isMainThread)
+			XCTAssertEqual(heights, serial)
+			e.fulfill()
+		}
+		wait(for: [e], timeout: 5)
+	}
+
+	private func measureSizing(maxConcurrency: Int) {
+		let descriptors = makeDescriptors(count: 2000)
+		let sizer = MMMBackgroundCellSizer(measurer: MMMStringDrawingTextMeasurer(scale: 2), maxConcurrency: maxConcurrency)
+		measure {
+			_ = sizer.heights(for: descriptors, width: 375)
+		}
+	}
+
+	public func testPerformance1() { measureSizing(maxConcurrency: 1) }
+	public func testPerformance2() { measureSizing(maxConcurrency: 2) }
+	public func testPerformance4() { measureSizing(maxConcurrency: 4) }
+	public func testPerformanceAllCores() { measureSizing(maxConcurrency: ProcessInfo.processInfo.activeProcessorCount) }
+}
@@ -0,0 +1,61 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMNavigationTestCase: XCTestCase {
+
+	public func testAtoms() {
+
+		let atom = MMMNavigationAtomForAction("recipes")
+		XCTAssertNotEqual(atom, 0)
+		XCTAssertEqual(MMMNavigationAtomForAction("recipes"), atom)
+		XCTAssertNotEqual(MMMNavigationAtomForAction("ingredients"), atom)
+		XCTAssertEqual(MMMNavigationActionForAtom(atom), "recipes")
+		XCTAssertNil(MMMNavigationActionForAtom(0))
+
+		XCTAssertEqual(MMMNavigationHop(action: "recipes").actionAtom, atom)
+	}
+
+	public func testEquality() {
+
+		let plain = MMMNavigationHop(action: "recipe")
+		let withId = MMMNavigationHop(action: "recipe", params: [ "id": 1 ])
+		let withOtherId = MMMNavigationHop(action: "recipe", params: [ "id": 2 ])
+
+		// A hop without parameters matches the same hop with any parameters, but not the other way around.
+		XCTAssertEqual(plain, withId)
+		XCTAssertNotEqual(withId, plain)
+		XCTAssertNotEqual(withId, withOtherId)
+		XCTAssertEqual(withId, MMMNavigationHop(action: "recipe", params: [ "id": 1 ]))
+		XCTAssertEqual(plain.hash, withId.hash)
+
+		let path = MMMNavigationPath(uri: "main/recipes/recipe")
+		XCTAssertEqual(path, MMMNavigationPath(uri: "main/recipes/recipe"))
+		XCTAssertEqual(path.hash, MMMNavigationPath(uri: "main/recipes/recipe").hash)
+		XCTAssertNotEqual(path, MMMNavigationPath(uri: "main/recipe/recipes"))
+		XCTAssertNotEqual(path, MMMNavigationPath(uri: "main/recipes"))
+
+		let set = Set<MMMNavigationPath>([ path, MMMNavigationPath(uri: "main/recipes/recipe"), MMMNavigationPath(uri: "main") ])
+		XCTAssertEqual(set.count, 2)
+	}
+
+	public func testDeduplicationPerformance() {
+
+		let paths = (0..<10_000).map { i in
+			MMMNavigationPath(hops: [
+				MMMNavigationHop(action: "main"),
+				MMMNavigationHop(action: "recipes"),
+				MMMNavigationHop(action: "recipe", params: [ "id": i % 100 ])
+			])
+		}
+
+		measure {
+			let unique = Set<MMMNavigationPath>(paths)
+			XCTAssertLessThanOrEqual(unique.count, paths.count)
+		}
+	}
+}
@@ -0,0 +1,52 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import Photos
+import XCTest
+
+class MMMPhotoLibraryLoadableImageTestCase: XCTestCase {
+
+	/// Loads via a fake performer instead of the Photo Library.
+	private class TestImage: MMMPhotoLibraryLoadableImage {
+
+		static let performer = MMMFakeImageRequestPerformer()
+
+		static let coalescer = MMMImageRequestCoalescer(performer: performer, maxConcurrentRequests: 4)
+
+		override class func requestCoalescer() -> MMMImageRequestCoalescer {
+			return coalescer
+		}
+	}
+
+	public func testFailedProgressiveLoad() {
+
+		// A unique identifier, so nothing is found in the shared cache.
+		let image = TestImage(
+			localIdentifier: UUID().uuidString,
+			targetSize: CGSize(width: 10, height: 10),
+			contentMode: .aspectFit,
+			progressive: true
+		)
+		image.sync()
+		guard let request = TestImage.performer.running.last else {
+			XCTFail("The image should be requested")
+			return
+		}
+
+		// The preview is available while still syncing...
+		request.progress?(makeImage(width: 5, height: 5))
+		let preview = expectation(for: NSPredicate { _, _ in image.isContentsAvailable }, evaluatedWith: nil)
+		wait(for: [preview], timeout: 1)
+		XCTAssertEqual(image.loadableState, .syncing)
+
+		// ...but is dropped when the final image fails to load.
+		request.completion(nil, NSError(domain: "Test", code: 1))
+		let failed = expectation(for: NSPredicate { _, _ in image.loadableState == .didFailToSync }, evaluatedWith: nil)
+		wait(for: [failed], timeout: 1)
+		XCTAssertFalse(image.isContentsAvailable)
+		XCTAssertNil(image.image)
+	}
+}
@@ -0,0 +1,50 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMPhotoTestCase: XCTestCase {
+
+	private lazy var largeImage: UIImage = makeImage(width: 1200, height: 800)
+
+	private func loaded(_ image: MMMLoadableImage) -> UIImage? {
+		image.syncIfNeeded()
+		let e = expectation(for: NSPredicate { _, _ in image.isContentsAvailable }, evaluatedWith: nil)
+		wait(for: [e], timeout: 5)
+		return image.image
+	}
+
+	public func testVariants() {
+
+		let photo = MMMPhotoFromUIImage(image: largeImage)
+
+		let thumbnail = photo.image(forTargetSize: CGSize(width: 120, height: 120), contentMode: .aspectFit)
+		// The same loadable while it's in use.
+		XCTAssert(thumbnail === photo.image(forTargetSize: CGSize(width: 120, height: 120), contentMode: .aspectFit))
+
+		let fit = loaded(thumbnail)
+		XCTAssertEqual(fit?.cgImage?.width, 120)
+		XCTAssertEqual(fit?.cgImage?.height, 80)
+
+		let fill = loaded(photo.image(forTargetSize: CGSize(width: 120, height: 120), contentMode: .aspectFill))
+		XCTAssertEqual(fill?.cgImage?.width, 180)
+		XCTAssertEqual(fill?.cgImage?.height, 120)
+
+		// Larger sizes are served by the original.
+		let full = photo.image(forTargetSize: CGSize(width: 2000, height: 2000), contentMode: .aspectFit)
+		XCTAssert(full.isContentsAvailable)
+		XCTAssert(full.image === largeImage)
+	}
+
+	public func testPerformance() {
+		measure {
+			let photo = MMMPhotoFromUIImage(image: largeImage)
+			for size in stride(from: 60, to: 180, by: 30) {
+				_ = loaded(photo.image(forTargetSize: CGSize(width: size, height: size), contentMode: .aspectFill))
+			}
+		}
+	}
+}
@@ -0,0 +1,66 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMPlaceholderImageTestCase: XCTestCase {
+
+	public func testDeterministic() {
+
+		let size = CGSize(width: 64, height: 48)
+		let a = MMMPlaceholderImageWithIndex(7, size)
+		XCTAssertEqual(a.size, size)
+		XCTAssertEqual(a.scale, 1)
+
+		let b = MMMPlaceholderImageWithIndex(7, size)
+		XCTAssertEqual(a.pngData(), b.pngData())
+
+		let c = MMMPlaceholderImageWithIndex(8, size)
+		XCTAssertNotEqual(a.pngData(), c.pngData())
+	}
+
+	public func testLoader() {
+
+		let loader = MMMPlaceholderImageLoader()
+		loader.latency = 0.2
+		loader.bandwidth = 0
+
+		let start = CACurrentMediaTime()
+		let loaded = expectation(description: "loaded")
+		loader.loadImage(index: 3, pixelSize: CGSize(width: 32, height: 32)) { image in
+			XCTAssert(Thread.isMainThread)
+			XCTAssertEqual(image.size, CGSize(width: 32, height: 32))
+			XCTAssertGreaterThanOrEqual(CACurrentMediaTime() - start, 0.2)
+			loaded.fulfill()
+		}
+		wait(for: [loaded], timeout: 2)
+
+		XCTAssertEqual(loader.numberOfRequests, 1)
+		XCTAssertGreaterThan(loader.numberOfTransferredBytes, 0)
+	}
+
+	public func testLoadable() {
+
+		let loader = MMMPlaceholderImageLoader()
+		loader.latency = 0
+
+		let image = MMMPlaceholderLoadableImage(index: 1, pixelSize: CGSize(width: 16, height: 16), loader: loader)
+		let synced = expectation(for: NSPredicate { _, _ in image.loadableState == .didSyncSuccessfully }, evaluatedWith: nil)
+		image.sync()
+		wait(for: [synced], timeout: 2)
+		XCTAssert(image.isContentsAvailable)
+		XCTAssertNotNil(image.image)
+	}
+
+	public func testPerformance() {
+		let size = CGSize(width: 256, height: 256)
+		measure {
+			for i in 0..<20 {
+				_ = MMMPlaceholderImageWithIndex(i, size)
+			}
+		}
+	}
+}
@@ -0,0 +1,103 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMPreferredSizeChangesTestCase: XCTestCase {
+
+	private class Container: UIView, MMMPreferredSizeChanges {
+
+		var batches: [[UIView]] = []
+
+		func mmm_preferredSizeCouldChange(forSubview subview: UIView) {
+			batches.append([subview])
+		}
+
+		func mmm_preferredSizeCouldChange(forSubviews subviews: [UIView]) {
+			batches.append(subviews)
+		}
+	}
+
+	private class SingleContainer: UIView, MMMPreferredSizeChanges {
+
+		var notified: [UIView] = []
+
+		func mmm_preferredSizeCouldChange(forSubview subview: UIView) {
+			notified.append(subview)
+		}
+	}
+
+	public func testBatching() {
+
+		let container = Container()
+		let cell = UIView()
+		container.addSubview(cell)
+		let labels = (0..<30).map { _ in UILabel() }
+		labels.forEach { cell.addSubview($0) }
+
+		for label in labels {
+			label.mmm_setPreferredSizeCouldChange()
+			label.mmm_setPreferredSizeCouldChange()
+		}
+
+		// Nothing till the end of the run loop iteration.
+		XCTAssert(container.batches.isEmpty)
+
+		UIView.mmm_deliverPreferredSizeChanges()
+		XCTAssertEqual(container.batches.count, 1)
+		XCTAssertEqual(container.batches.first?.count, 30)
+
+		// Nothing pending anymore.
+		UIView.mmm_deliverPreferredSizeChanges()
+		XCTAssertEqual(container.batches.count, 1)
+
+		// The same but delivered by the run loop.
+		labels[0].mmm_setPreferredSizeCouldChange()
+		let e = expectation(for: NSPredicate { _, _ in container.batches.count == 2 }, evaluatedWith: nil)
+		wait(for: [e], timeout: 2)
+	}
+
+	public func testHierarchyChanges() {
+
+		let container1 = Container()
+		let container2 = SingleContainer()
+		let label1 = UILabel(), label2 = UILabel()
+		container1.addSubview(label1)
+		container1.addSubview(label2)
+
+		label1.mmm_setPreferredSizeCouldChange()
+		UIView.mmm_deliverPreferredSizeChanges()
+		XCTAssertEqual(container1.batches.count, 1)
+
+		// The cached parent should not be used after the move.
+		let wrapper = UIView()
+		container2.addSubview(wrapper)
+		wrapper.addSubview(label1)
+		label1.mmm_setPreferredSizeCouldChange()
+		label2.mmm_setPreferredSizeCouldChange()
+		UIView.mmm_deliverPreferredSizeChanges()
+		XCTAssertEqual(container2.notified, [label1])
+		XCTAssertEqual(container1.batches.count, 2)
+		XCTAssertEqual(container1.batches.last, [label2])
+
+		// Moving one of the ancestors should be picked up as well.
+		container1.addSubview(wrapper)
+		label1.mmm_setPreferredSizeCouldChange()
+		UIView.mmm_deliverPreferredSizeChanges()
+		XCTAssertEqual(container2.notified, [label1])
+		XCTAssertEqual(container1.batches.count, 3)
+		XCTAssertEqual(container1.batches.last, [label1])
+
+		// Scroll views stop the search.
+		let scrollView = UIScrollView()
+		container1.addSubview(scrollView)
+		let label3 = UILabel()
+		scrollView.addSubview(label3)
+		label3.mmm_setPreferredSizeCouldChange()
+		UIView.mmm_deliverPreferredSizeChanges()
+		XCTAssertEqual(container1.batches.count, 3)
+	}
+}
@@ -0,0 +1,175 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMPrefetchCoordinatorTestCase: XCTestCase {
+
+	public func testPolicy() {
+
+		let policy = MMMPrefetchPolicy()
+
+		// Not scrolling: visible rows and a few on both sides.
+		let idle = policy.priorities(visibleRange: 10..<15, velocity: 0, numberOfRows: 100)
+		XCTAssertEqual(Set(idle.keys), Set(6..<19))
+		XCTAssertLessThan(idle[14]!, idle[15]!)
+		XCTAssertEqual(idle[15], idle[9])
+
+		// Scrolling down fast: more rows ahead, closer ones first, only a couple behind and after everything ahead.
+		let fast = policy.priorities(visibleRange: 10..<15, velocity: 10, numberOfRows: 100)
+		XCTAssertEqual(Set(fast.keys), Set(8..<30))
+		XCTAssertLessThan(fast[15]!, fast[16]!)
+		XCTAssertLessThan(fast[29]!, fast[9]!)
+
+		// Scrolling up, limited by the beginning of the list.
+		let up = policy.priorities(visibleRange: 3..<8, velocity: -10, numberOfRows: 100)
+		XCTAssertEqual(Set(up.keys), Set(0..<10))
+		XCTAssertLessThan(up[2]!, up[8]!)
+
+		// Never more than the limit.
+		let veryFast = policy.priorities(visibleRange: 10..<15, velocity: 1000, numberOfRows: 100)
+		XCTAssertEqual(veryFast.keys.filter { $0 >= 15 }.count, policy.maxLookaheadRows)
+	}
+
+	public func testConcurrencyAndScrollingPast() {
+
+		let images = (0..<100).map { _ in MMMTestLoadableImage() }
+		var policy = MMMPrefetchPolicy()
+		policy.minLookaheadRows = 2
+		let coordinator = MMMPrefetchCoordinator(maxConcurrentLoads: 3, policy: policy) { images[$0] }
+
+		coordinator.update(visibleRange: 0..<5, velocity: 0, numberOfRows: images.count)
+		XCTAssertEqual(images.filter { $0.loadableState == .syncing }.count, 3)
+		XCTAssertEqual(images[0].loadableState, .syncing)
+		XCTAssertEqual(images[5].loadableState, .idle)
+
+		// Completed loads free their slots.
+		images[0].setDidSyncSuccessfullyWith(UIImage())
+		XCTAssertEqual(images[3].loadableState, .syncing)
+
+		// Everything is far behind now, but the dropped loads are still running, so nothing new can start.
+		coordinator.update(visibleRange: 50..<55, velocity: 0, numberOfRows: images.count)
+		XCTAssertEqual(coordinator.numberOfDroppedLoads, 3)
+		XCTAssertEqual(images.filter { $0.loadableState == .syncing }.count, 3)
+		XCTAssertEqual(images[50].loadableState, .idle)
+
+		// The slots of the dropped loads are reused on the next update after they finish.
+		images[1].setDidSyncSuccessfullyWith(UIImage())
+		images[2].setDidSyncSuccessfullyWith(UIImage())
+		coordinator.update(visibleRange: 50..<55, velocity: 0, numberOfRows: images.count)
+		XCTAssertEqual(images.filter { $0.loadableState == .syncing }.count, 3)
+		XCTAssertEqual(images[50].loadableState, .syncing)
+		XCTAssertEqual(images[51].loadableState, .syncing)
+	}
+
+	public func testFailedLoadsAreNotRetried() {
+
+		let images = (0..<100).map { _ in MMMTestLoadableImage() }
+		var policy = MMMPrefetchPolicy()
+		policy.minLookaheadRows = 2
+		let coordinator = MMMPrefetchCoordinator(maxConcurrentLoads: 3, policy: policy) { images[$0] }
+
+		coordinator.update(visibleRange: 0..<5, velocity: 0, numberOfRows: images.count)
+		XCTAssertEqual(images[0].loadableState, .syncing)
+
+		// Always failing; the slot is reused for another row, but the failed one is not synced again.
+		images[0].setDidFailToSyncWithError(nil)
+		XCTAssertEqual(images[3].loadableState, .syncing)
+		for _ in 0..<5 {
+			coordinator.update(visibleRange: 0..<5, velocity: 0, numberOfRows: images.count)
+			XCTAssertEqual(images[0].loadableState, .didFailToSync)
+		}
+		XCTAssertEqual(coordinator.numberOfStartedLoads, 4)
+
+		// Until it is scrolled past and back.
+		coordinator.update(visibleRange: 50..<55, velocity: 0, numberOfRows: images.count)
+		while let image = images.first(where: { $0.loadableState == .syncing }) {
+			image.setDidSyncSuccessfullyWith(UIImage())
+		}
+		coordinator.update(visibleRange: 0..<5, velocity: 0, numberOfRows: images.count)
+		XCTAssertEqual(images[0].loadableState, .syncing)
+	}
+
+	public func testScrollViewDidScroll() {
+
+		let images = (0..<100).map { _ in MMMTestLoadableImage() }
+		let coordinator = MMMPrefetchCoordinator(maxConcurrentLoads: 4) { images[$0] }
+
+		let scrollView = UIScrollView(frame: CGRect(x: 0, y: 0, width: 320, height: 500))
+		scrollView.contentSize = CGSize(width: 320, height: 100 * 50)
+		for step in 0..<5 {
+			scrollView.contentOffset = CGPoint(x: 0, y: CGFloat(step) * 50)
+			coordinator.scrollViewDidScroll(scrollView, visibleRange: step..<(step + 10), numberOfRows: images.count)
+		}
+
+		XCTAssertGreaterThan(coordinator.numberOfStartedLoads, 0)
+		XCTAssertLessThanOrEqual(images.filter { $0.loadableState == .syncing }.count, 4)
+	}
+
+	/// Replays a fling (exponentially decaying velocity) and counts how many rows were loaded by the time
+	/// they became visible, with and without prefetching.
+	private func simulateFling(policy: MMMPrefetchPolicy) -> Double {
+
+		let images = (0..<300).map { _ in MMMTestLoadableImage() }
+		let coordinator = MMMPrefetchCoordinator(maxConcurrentLoads: 4, policy: policy) { images[$0] }
+
+		let latency: TimeInterval = 0.25
+		let initialVelocity: Double = 30
+		let decay: Double = 0.8
+		let visibleCount = 8
+		let dt = 1.0 / 60
+
+		var started = [Int: TimeInterval]()
+		var seen = Set<Int>()
+		var hits = 0
+
+		for step in 0..<(4 * 60) {
+
+			let t = Double(step) * dt
+			let position = initialVelocity * decay * (1 - exp(-t / decay))
+			let velocity = initialVelocity * exp(-t / decay)
+			let first = Int(position)
+			let visible = first..<(first + visibleCount)
+
+			// Cells being configured load their images if they are not there yet.
+			for index in visible where !seen.contains(index) {
+				seen.insert(index)
+				if images[index].isContentsAvailable {
+					hits += 1
+				} else {
+					images[index].syncIfNeeded()
+				}
+			}
+
+			coordinator.update(visibleRange: visible, velocity: CGFloat(velocity), numberOfRows: images.count)
+
+			for (index, image) in images.enumerated() where image.loadableState == .syncing {
+				if let s = started[index] {
+					if t - s >= latency {
+						image.setDidSyncSuccessfullyWith(UIImage())
+					}
+				} else {
+					started[index] = t
+				}
+			}
+		}
+
+		return Double(hits) / Double(seen.count)
+	}
+
+	public func testFlingSimulation() {
+
+		var noPrefetch = MMMPrefetchPolicy()
+		noPrefetch.minLookaheadRows = 0
+		noPrefetch.maxLookaheadRows = 0
+		noPrefetch.trailingRows = 0
+
+		let baseline = simulateFling(policy: noPrefetch)
+		let prefetched = simulateFling(policy: MMMPrefetchPolicy())
+
+		XCTAssertGreaterThan(prefetched, baseline + 0.2)
+	}
+}
@@ -0,0 +1,109 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMRowHeightCacheTestCase: XCTestCase {
+
+	private let large = UIContentSizeCategory.large.rawValue
+	private let extraLarge = UIContentSizeCategory.extraLarge.rawValue
+
+	public func testBasics() {
+
+		let cache = MMMRowHeightCache()
+		XCTAssertEqual(cache.height(forContentHash: 1, width: 320, contentSizeCategory: large), 0)
+
+		cache.setHeight(44, forContentHash: 1, width: 320, contentSizeCategory: large)
+		XCTAssertEqual(cache.height(forContentHash: 1, width: 320, contentSizeCategory: large), 44)
+		XCTAssertEqual(cache.count, 1)
+
+		// Every part of the key matters.
+		XCTAssertEqual(cache.height(forContentHash: 2, width: 320, contentSizeCategory: large), 0)
+		XCTAssertEqual(cache.height(forContentHash: 1, width: 375, contentSizeCategory: large), 0)
+		XCTAssertEqual(cache.height(forContentHash: 1, width: 320, contentSizeCategory: extraLarge), 0)
+
+		// Overwriting does not add entries.
+		cache.setHeight(50.5, forContentHash: 1, width: 320, contentSizeCategory: large)
+		XCTAssertEqual(cache.height(forContentHash: 1, width: 320, contentSizeCategory: large), 50.5)
+		XCTAssertEqual(cache.count, 1)
+
+		// Invalid heights are ignored.
+		cache.setHeight(0, forContentHash: 3, width: 320, contentSizeCategory: large)
+		XCTAssertEqual(cache.count, 1)
+
+		cache.removeAllHeights()
+		XCTAssertEqual(cache.count, 0)
+		XCTAssertEqual(cache.height(forContentHash: 1, width: 320, contentSizeCategory: large), 0)
+	}
+
+	public func testEviction() {
+
+		let cache = MMMRowHeightCache(fileURL: nil, capacity: 64)
+		XCTAssertEqual(cache.capacity, 64)
+
+		for i in 0..<1000 {
+			cache.setHeight(CGFloat(i + 1), forContentHash: UInt64(i), width: 320, contentSizeCategory: large)
+		}
+		XCTAssertLessThanOrEqual(cache.count, 64)
+
+		// The most recent one is always there.
+		XCTAssertEqual(cache.height(forContentHash: 999, width: 320, contentSizeCategory: large), 1000)
+	}
+
+	public func testPersistence() {
+
+		let url = FileManager.default.temporaryDirectory.appendingPathComponent("MMMRowHeightCacheTestCase.bin")
+		try? FileManager.default.removeItem(at: url)
+		defer { try? FileManager.default.removeItem(at: url) }
+
+		do {
+			let cache = MMMRowHeightCache(fileURL: url, capacity: 128)
+			for i in 0..<50 {
+				cache.setHeight(CGFloat(i + 10), forContentHash: UInt64(i), width: 320, contentSizeCategory: large)
+			}
+			cache.synchronize()
+		}
+
+		do {
+			let cache = MMMRowHeightCache(fileURL: url, capacity: 128)
+			XCTAssertEqual(cache.count, 50)
+			for i in 0..<50 {
+				XCTAssertEqual(cache.height(forContentHash: UInt64(i), width: 320, contentSizeCategory: large), CGFloat(i + 10))
+			}
+		}
+
+		// A different capacity means a different format, so it starts from scratch.
+		do {
+			let cache = MMMRowHeightCache(fileURL: url, capacity: 256)
+			XCTAssertEqual(cache.count, 0)
+		}
+
+		// Garbage in the file is not trusted either.
+		try? Data(repeating: 0xAB, count: 100).write(to: url)
+		do {
+			let cache = MMMRowHeightCache(fileURL: url, capacity: 128)
+			XCTAssertEqual(cache.count, 0)
+		}
+	}
+
+	public func testPerformance() {
+
+		let cache = MMMRowHeightCache(fileURL: nil, capacity: 4096)
+		for i in 0..<3000 {
+			cache.setHeight(CGFloat(i % 200 + 40), forContentHash: UInt64(i), width: 375, contentSizeCategory: large)
+		}
+
+		measure {
+			var total: CGFloat = 0
+			for _ in 0..<100 {
+				for i in 0..<3000 {
+					total += cache.height(forContentHash: UInt64(i), width: 375, contentSizeCategory: large)
+				}
+			}
+			XCTAssertGreaterThan(total, 0)
+		}
+	}
+}
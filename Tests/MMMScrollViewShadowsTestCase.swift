@@ -0,0 +1,105 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMScrollViewShadowsTestCase: XCTestCase {
+
+	private func rasterize(
+		width: Int, height: Int,
+		alignment: MMMScrollViewShadowAlignment,
+		alpha: CGFloat = 0.3, curvature: CGFloat = 0.5
+	) -> [UInt8] {
+		var pixels = [UInt8](repeating: 0xFF, count: width * height * 4)
+		MMMScrollViewShadowRasterize(&pixels, width, height, width * 4, alignment, alpha, curvature)
+		return pixels
+	}
+
+	public func testRasterizer() {
+
+		let width = 64, height = 10
+		let top = rasterize(width: width, height: height, alignment: .top)
+		let alpha = { (x: Int, y: Int) -> UInt8 in top[(y * width + x) * 4 + 3] }
+
+		// Premultiplied black.
+		XCTAssert(stride(from: 0, to: top.count, by: 4).allSatisfy { top[$0] == 0 && top[$0 + 1] == 0 && top[$0 + 2] == 0 })
+
+		// The darkest in the middle of the edge the shadow is attached to, fading away from it.
+		XCTAssertGreaterThan(alpha(width / 2, 0), 0)
+		XCTAssertLessThanOrEqual(Double(alpha(width / 2, 0)), pow(0.3, 2.0.squareRoot()) * 255 + 1)
+		for y in 1..<height {
+			XCTAssertLessThanOrEqual(alpha(width / 2, y), alpha(width / 2, y - 1))
+		}
+
+		// Curved: the corners are lighter than the middle.
+		XCTAssertLessThan(alpha(0, 0), alpha(width / 2, 0))
+
+		// Symmetric.
+		for y in 0..<height {
+			for x in 0..<width / 2 {
+				XCTAssertEqual(alpha(x, y), alpha(width - 1 - x, y))
+			}
+		}
+
+		// The bottom one is the top one flipped.
+		let bottom = rasterize(width: width, height: height, alignment: .bottom)
+		for y in 0..<height {
+			XCTAssertEqual(
+				top[(y * width * 4)..<((y + 1) * width * 4)],
+				bottom[((height - 1 - y) * width * 4)..<((height - y) * width * 4)]
+			)
+		}
+	}
+
+	public func testFlatShadow() {
+		// Without curvature all columns should look almost the same.
+		let width = 64, height = 8
+		let pixels = rasterize(width: width, height: height, alignment: .top, curvature: 0)
+		for y in 0..<height {
+			let middle = Int(pixels[(y * width + width / 2) * 4 + 3])
+			let edge = Int(pixels[(y * width) * 4 + 3])
+			XCTAssertLessThanOrEqual(abs(middle - edge), 2)
+		}
+	}
+
+	public func testShadowHeights() {
+
+		XCTAssertEqual(MMMScrollViewTopShadowHeight(-10, 5), 0)
+		XCTAssertEqual(MMMScrollViewTopShadowHeight(0, 5), 0)
+		XCTAssertEqual(MMMScrollViewTopShadowHeight(20, 5), 2.5, accuracy: 1e-6)
+		XCTAssertEqual(MMMScrollViewTopShadowHeight(40, 5), 5)
+		XCTAssertEqual(MMMScrollViewTopShadowHeight(1000, 5), 5)
+
+		// The bottom one starts growing only after the content is scrolled by its full height.
+		XCTAssertEqual(MMMScrollViewBottomShadowHeight(10, 10), 0)
+		XCTAssertEqual(MMMScrollViewBottomShadowHeight(30, 10), 5, accuracy: 1e-6)
+		XCTAssertEqual(MMMScrollViewBottomShadowHeight(1000, 10), 10)
+	}
+
+	public func testRedundantWritesAreSuppressed() {
+
+		let settings = MMMScrollViewShadowsSettings()
+		settings.topShadowEnabled = true
+		settings.bottomShadowEnabled = true
+
+		let scrollView = UIScrollView(frame: CGRect(x: 0, y: 0, width: 320, height: 400))
+		scrollView.contentSize = CGSize(width: 320, height: 4000)
+		let shadows = MMMScrollViewShadows(scrollView: scrollView, settings: settings)
+
+		scrollView.contentOffset = CGPoint(x: 0, y: 1000)
+		shadows.layoutSubviews()
+		let suppressed = shadows.numberOfSuppressedWrites
+
+		// Nothing has changed, so none of the 4 properties (frame and hidden of both shadows) should be touched.
+		shadows.layoutSubviews()
+		XCTAssertEqual(shadows.numberOfSuppressedWrites, suppressed + 4)
+
+		// While scrolling in the middle only the frames follow the content offset.
+		scrollView.contentOffset = CGPoint(x: 0, y: 1010)
+		shadows.layoutSubviews()
+		XCTAssertEqual(shadows.numberOfSuppressedWrites, suppressed + 4 + 2)
+	}
+}
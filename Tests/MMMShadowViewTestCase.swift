@@ -0,0 +1,148 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMShadowViewTestCase: XCTestCase {
+
+	public func testBoxBlurRadius() {
+
+		XCTAssertEqual(MMMShadowBoxBlurRadiusForSigma(0, 3), 0)
+
+		// 3 passes of r = 2 have variance 3 * 2 * 3 / 3 = 6.
+		XCTAssertEqual(MMMShadowBoxBlurRadiusForSigma(6.0.squareRoot(), 3), 2)
+
+		for sigma in stride(from: 1.0, to: 20.0, by: 0.5) {
+			let r = Double(MMMShadowBoxBlurRadiusForSigma(CGFloat(sigma), 3))
+			XCTAssertEqual((r * (r + 1)).squareRoot(), sigma, accuracy: 0.5)
+		}
+	}
+
+	public func testBoxBlur() {
+
+		// A single dot in the middle.
+		let width = 41, height = 41
+		var pixels = [UInt8](repeating: 0, count: width * height)
+		pixels[20 * width + 20] = 255
+		pixels.withUnsafeMutableBufferPointer {
+			MMMShadowBoxBlur($0.baseAddress!, width, height, width, 1, 1)
+		}
+		// One pass of r = 1 spreads it evenly over a 3x3 square.
+		for y in 0..<height {
+			for x in 0..<width {
+				let inside = abs(x - 20) <= 1 && abs(y - 20) <= 1
+				XCTAssertLessThanOrEqual(abs(Int(pixels[y * width + x]) - (inside ? 255 / 9 : 0)), 1)
+			}
+		}
+
+		// A solid image stays solid away from the edges and fades towards them symmetrically.
+		var solid = [UInt8](repeating: 200, count: width * height)
+		solid.withUnsafeMutableBufferPointer {
+			MMMShadowBoxBlur($0.baseAddress!, width, height, width, 2, 3)
+		}
+		XCTAssertEqual(solid[20 * width + 20], 200)
+		XCTAssertLessThan(solid[20 * width], solid[20 * width + 20])
+		for y in 0..<height {
+			for x in 0..<width / 2 {
+				XCTAssertEqual(solid[y * width + x], solid[y * width + width - 1 - x])
+			}
+		}
+	}
+
+	private func makeSettings() -> [MMMShadowViewSetting] {
+		return [
+			MMMShadowViewSetting { s in
+				s.opacity = 0.3
+				s.radius = 6
+				s.offset = CGSize(width: 0, height: 2)
+				s.cornerRadius = 8
+			}
+		]
+	}
+
+	public func testShadowPath() {
+
+		let view = MMMShadowView(settings: makeSettings())
+		view.frame = CGRect(x: 0, y: 0, width: 100, height: 50)
+		view.layoutIfNeeded()
+
+		let shadowLayers = view.layer.sublayers?.filter { $0.shadowOpacity > 0 } ?? []
+		XCTAssertEqual(shadowLayers.count, 1)
+		let path = shadowLayers.first?.shadowPath
+		XCTAssertNotNil(path)
+		XCTAssertEqual(path?.boundingBox, CGRect(x: 0, y: 0, width: 100, height: 50))
+
+		// The same size, the same path.
+		view.frame = CGRect(x: 10, y: 10, width: 100, height: 50)
+		view.layoutIfNeeded()
+		XCTAssert(shadowLayers.first?.shadowPath === path)
+
+		view.frame = CGRect(x: 10, y: 10, width: 120, height: 50)
+		view.layoutIfNeeded()
+		XCTAssertEqual(shadowLayers.first?.shadowPath?.boundingBox, CGRect(x: 0, y: 0, width: 120, height: 50))
+	}
+
+	public func testInsetsLargerThanContent() {
+
+		let settings = makeSettings()
+		settings[0].insets = UIEdgeInsets(top: 4, left: 4, bottom: 4, right: 4)
+		let view = MMMShadowView(settings: settings)
+		view.frame = .zero
+		view.layoutIfNeeded()
+
+		let shadowLayers = view.layer.sublayers?.filter { $0.shadowOpacity > 0 } ?? []
+		XCTAssertEqual(shadowLayers.count, 1)
+		XCTAssertNil(shadowLayers.first?.shadowPath)
+		XCTAssertEqual(shadowLayers.first?.frame.size, .zero)
+
+		view.frame = CGRect(x: 0, y: 0, width: 100, height: 50)
+		view.layoutIfNeeded()
+		XCTAssertEqual(shadowLayers.first?.shadowPath?.boundingBox, CGRect(x: 0, y: 0, width: 92, height: 42))
+
+		// Back to nothing.
+		view.frame = CGRect(x: 0, y: 0, width: 6, height: 50)
+		view.layoutIfNeeded()
+		XCTAssertNil(shadowLayers.first?.shadowPath)
+	}
+
+	public func testBakedShadows() {
+
+		let settings = makeSettings()
+		let view1 = MMMShadowView(settings: settings)
+		view1.bakesShadows = true
+		let view2 = MMMShadowView(settings: settings)
+		view2.bakesShadows = true
+
+		// No shadows rendered by Core Animation, but bitmaps shared between the views.
+		for view in [view1, view2] {
+			XCTAssert(view.layer.sublayers?.allSatisfy { $0.shadowOpacity == 0 } ?? false)
+		}
+		let contents1 = view1.layer.sublayers?.compactMap { $0.contents }
+		let contents2 = view2.layer.sublayers?.compactMap { $0.contents }
+		XCTAssertEqual(contents1?.count, 1)
+		XCTAssert(contents1?.first as AnyObject === contents2?.first as AnyObject)
+	}
+
+	public func testBlurPerformance() {
+
+		let size = 256
+		var pixels = [UInt8](repeating: 0, count: size * size)
+		for y in size / 4..<size * 3 / 4 {
+			for x in size / 4..<size * 3 / 4 {
+				pixels[y * size + x] = 255
+			}
+		}
+
+		measure {
+			for _ in 0..<10 {
+				var copy = pixels
+				copy.withUnsafeMutableBufferPointer {
+					MMMShadowBoxBlur($0.baseAddress!, size, size, size, 8, 3)
+				}
+			}
+		}
+	}
+}
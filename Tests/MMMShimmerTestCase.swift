@@ -0,0 +1,74 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMShimmerTestCase: XCTestCase {
+
+	public func testGeometry() {
+
+		var geometry = MMMShimmerGeometry()
+		geometry.period = 2
+		XCTAssertEqual(geometry.phase(at: 0), 0)
+		XCTAssertEqual(geometry.phase(at: 1), 0.5, accuracy: 1e-6)
+		XCTAssertEqual(geometry.phase(at: 5), 0.5, accuracy: 1e-6)
+
+		let window = CGSize(width: 320, height: 640)
+		for y in stride(from: CGFloat(0), through: window.height, by: 40) {
+			// Fully outside on both ends of the cycle regardless of the vertical position.
+			let start = geometry.bandCenter(phase: 0, windowSize: window, y: y)
+			XCTAssertLessThanOrEqual(start + geometry.bandWidth / 2, 0)
+			let end = geometry.bandCenter(phase: 1, windowSize: window, y: y)
+			XCTAssertGreaterThanOrEqual(end - geometry.bandWidth / 2, window.width)
+		}
+
+		// Lower rows are behind, so the band goes diagonally.
+		XCTAssertGreaterThan(
+			geometry.bandCenter(phase: 0.5, windowSize: window, y: 0),
+			geometry.bandCenter(phase: 0.5, windowSize: window, y: 100)
+		)
+	}
+
+	public func testStartsAndStops() {
+
+		let driver = MMMShimmerDriver(animator: MMMAnimator())
+		let window = UIWindow(frame: CGRect(x: 0, y: 0, width: 320, height: 640))
+		window.isHidden = false
+
+		let views = (0..<30).map { _ in MMMShimmerView(driver: driver) }
+		XCTAssertFalse(driver.isRunning)
+
+		for (i, view) in views.enumerated() {
+			view.translatesAutoresizingMaskIntoConstraints = true
+			view.frame = CGRect(x: 10, y: CGFloat(i) * 20, width: 100, height: 16)
+			window.addSubview(view)
+		}
+		// A single item for all the views.
+		XCTAssert(driver.isRunning)
+
+		let updated = expectation(for: NSPredicate { _, _ in driver.numberOfUpdates > 0 }, evaluatedWith: nil)
+		wait(for: [updated], timeout: 2)
+
+		views.forEach { $0.removeFromSuperview() }
+		let stopped = expectation(for: NSPredicate { _, _ in !driver.isRunning }, evaluatedWith: nil)
+		wait(for: [stopped], timeout: 2)
+	}
+
+	public func testPerformance() {
+		let geometry = MMMShimmerGeometry()
+		let window = CGSize(width: 390, height: 844)
+		measure {
+			var sum: CGFloat = 0
+			for frame in 0..<600 {
+				let phase = geometry.phase(at: Double(frame) / 60)
+				for view in 0..<40 {
+					sum += geometry.bandCenter(phase: phase, windowSize: window, y: CGFloat(view) * 20)
+				}
+			}
+			XCTAssert(sum.isFinite)
+		}
+	}
+}
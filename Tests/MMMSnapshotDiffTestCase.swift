@@ -0,0 +1,203 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMSnapshotDiffTestCase: XCTestCase {
+
+	private typealias Snapshot = MMMSnapshot<String, Int>
+
+	private func snapshot(_ sections: [(String, [Int])]) -> Snapshot {
+		var s = Snapshot()
+		for (id, items) in sections {
+			s.appendSection(id, items: items)
+		}
+		return s
+	}
+
+	/// Checks that the changes turn `old` into `new` following the rules of batch updates: whatever is not deleted,
+	/// inserted or moved keeps its relative order.
+	private func verify(_ old: Snapshot, _ new: Snapshot, _ changes: MMMSnapshotChanges, file: StaticString = #file, line: UInt = #line) {
+
+		// Sections: the ones not deleted/moved map in order onto the ones not inserted/moved.
+		let movedFrom = Set(changes.movedSections.map { $0.from })
+		let movedTo = Set(changes.movedSections.map { $0.to })
+		let stayingOld = old.sectionIdentifiers.indices.filter { !changes.deletedSections.contains($0) && !movedFrom.contains($0) }
+		let stayingNew = new.sectionIdentifiers.indices.filter { !changes.insertedSections.contains($0) && !movedTo.contains($0) }
+		XCTAssertEqual(stayingOld.count, stayingNew.count, file: file, line: line)
+		var sectionNewToOld = [Int: Int]()
+		for (o, n) in zip(stayingOld, stayingNew) {
+			sectionNewToOld[n] = o
+		}
+		for move in changes.movedSections {
+			sectionNewToOld[move.to] = move.from
+		}
+		for (n, o) in sectionNewToOld {
+			XCTAssertEqual(old.sectionIdentifiers[o], new.sectionIdentifiers[n], file: file, line: line)
+		}
+
+		// Items within every section.
+		let deleted = Set(changes.deletedItems)
+		let inserted = Set(changes.insertedItems)
+		let itemsMovedFrom = Set(changes.movedItems.map { $0.from })
+		let itemsMovedTo = Set(changes.movedItems.map { $0.to })
+		for move in changes.movedItems {
+			XCTAssertEqual(old.itemIdentifiers[move.from.section][move.from.row], new.itemIdentifiers[move.to.section][move.to.row], file: file, line: line)
+		}
+		for (n, o) in sectionNewToOld {
+			let stayingOldItems = old.itemIdentifiers[o].indices
+				.filter { let p = IndexPath(row: $0, section: o); return !deleted.contains(p) && !itemsMovedFrom.contains(p) }
+				.map { old.itemIdentifiers[o][$0] }
+			let stayingNewItems = new.itemIdentifiers[n].indices
+				.filter { let p = IndexPath(row: $0, section: n); return !inserted.contains(p) && !itemsMovedTo.contains(p) }
+				.map { new.itemIdentifiers[n][$0] }
+			XCTAssertEqual(stayingOldItems, stayingNewItems, file: file, line: line)
+		}
+	}
+
+	public func testMyers() {
+		let (deleted, inserted) = MMMDiff.myers(Array("ABCABBA"), Array("CBABAC"))
+		// The classic example from the paper has 5 edits.
+		XCTAssertEqual(deleted.count + inserted.count, 5)
+		var result = Array("ABCABBA").enumerated().filter { !deleted.contains($0.offset) }.map { $0.element }
+		for i in inserted {
+			result.insert(Array("CBABAC")[i], at: i)
+		}
+		XCTAssertEqual(String(result), "CBABAC")
+
+		XCTAssert(MMMDiff.myers([Int](), []) == ([], []))
+		XCTAssert(MMMDiff.myers([], [1, 2]) == ([], [0, 1]))
+		XCTAssert(MMMDiff.myers([1, 2], []) == ([0, 1], []))
+	}
+
+	public func testMyersRandom() {
+
+		var rng = SystemRandomNumberGenerator()
+		for _ in 0..<200 {
+
+			// Small alphabets, so there are plenty of duplicates.
+			let alphabet = Int.random(in: 1...5, using: &rng)
+			let old = (0..<Int.random(in: 0...30, using: &rng)).map { _ in Int.random(in: 0..<alphabet, using: &rng) }
+			let new = (0..<Int.random(in: 0...30, using: &rng)).map { _ in Int.random(in: 0..<alphabet, using: &rng) }
+
+			let (deleted, inserted) = MMMDiff.myers(old, new)
+			XCTAssertEqual(deleted, deleted.sorted())
+			XCTAssertEqual(inserted, inserted.sorted())
+
+			// The script is the shortest one, i.e. it keeps the longest common subsequence.
+			var lcs = [[Int]](repeating: [Int](repeating: 0, count: new.count + 1), count: old.count + 1)
+			for i in 0..<old.count {
+				for j in 0..<new.count {
+					lcs[i + 1][j + 1] = old[i] == new[j] ? lcs[i][j] + 1 : max(lcs[i][j + 1], lcs[i + 1][j])
+				}
+			}
+			XCTAssertEqual(deleted.count + inserted.count, old.count + new.count - 2 * lcs[old.count][new.count])
+
+			let deletedSet = Set(deleted)
+			var result = old.enumerated().filter { !deletedSet.contains($0.offset) }.map { $0.element }
+			for i in inserted {
+				result.insert(new[i], at: i)
+			}
+			XCTAssertEqual(result, new)
+		}
+	}
+
+	public func testLIS() {
+		XCTAssertEqual(MMMDiff.longestIncreasingSubsequence([0, 1, 2, 3]), [0, 1, 2, 3])
+		XCTAssertEqual(MMMDiff.longestIncreasingSubsequence([3, 0, 1, 2]), [1, 2, 3])
+		XCTAssertEqual(MMMDiff.longestIncreasingSubsequence([]), [])
+	}
+
+	public func testBasics() {
+
+		let old = snapshot([("a", [1, 2, 3, 4]), ("b", [5, 6]), ("c", [7])])
+		let new = snapshot([("b", [6, 5, 10]), ("a", [1, 3, 4, 2]), ("d", [11])])
+		let changes = old.changes(to: new, reloaded: [3])!
+
+		XCTAssertEqual(changes.deletedSections, [2])
+		XCTAssertEqual(changes.insertedSections, [2])
+		XCTAssertEqual(changes.movedSections.count, 1)
+		// One move within "a" and one within "b".
+		XCTAssertEqual(changes.movedItems.count, 2)
+		XCTAssertEqual(changes.reloadedItems, [IndexPath(row: 2, section: 0)])
+		verify(old, new, changes)
+
+		XCTAssert(old.changes(to: old)!.isEmpty)
+
+		// Duplicate sections cannot be diffed.
+		XCTAssertNil(old.changes(to: snapshot([("a", []), ("a", [])])))
+
+		// Duplicate items are compared per section with no moves.
+		let dups = snapshot([("a", [1, 1, 2]), ("b", [5])])
+		let dupChanges = old.changes(to: dups)!
+		XCTAssert(dupChanges.movedItems.isEmpty)
+		verify(old, dups, dupChanges)
+	}
+
+	private func randomSnapshot(from base: Snapshot?, sections: Int, items: Int, rng: inout SystemRandomNumberGenerator) -> Snapshot {
+		var result = Snapshot()
+		var nextItem = 100_000
+		if let base = base {
+			var sectionIDs = base.sectionIdentifiers.filter { _ in Int.random(in: 0..<5, using: &rng) > 0 }
+			sectionIDs.append("new\(Int.random(in: 0..<1000, using: &rng))")
+			var allItems = base.itemIdentifiers.joined().filter { _ in Int.random(in: 0..<10, using: &rng) > 0 }
+			for _ in 0..<items / 10 {
+				allItems.insert(nextItem, at: Int.random(in: 0...allItems.count, using: &rng))
+				nextItem += 1
+			}
+			for _ in 0..<3 {
+				allItems.swapAt(Int.random(in: allItems.indices, using: &rng), Int.random(in: allItems.indices, using: &rng))
+			}
+			let perSection = max(1, allItems.count / sectionIDs.count)
+			for (i, id) in Set(sectionIDs).sorted().enumerated() {
+				let start = min(allItems.count, i * perSection)
+				let end = i == sectionIDs.count - 1 ? allItems.count : min(allItems.count, start + perSection)
+				result.appendSection(id, items: Array(allItems[start..<end]))
+			}
+		} else {
+			for s in 0..<sections {
+				result.appendSection("s\(s)", items: Array((s * items)..<((s + 1) * items)))
+			}
+		}
+		return result
+	}
+
+	public func testRandom() {
+		var rng = SystemRandomNumberGenerator()
+		for _ in 0..<50 {
+			let old = randomSnapshot(from: nil, sections: 5, items: 20, rng: &rng)
+			let new = randomSnapshot(from: old, sections: 0, items: 20, rng: &rng)
+			let changes = old.changes(to: new, reloaded: Set(old.itemIdentifiers.joined().prefix(10)))!
+			verify(old, new, changes)
+		}
+	}
+
+	public func testPerformanceHeckel() {
+		let old = Array(0..<100_000)
+		var new = old.filter { $0 % 100 != 0 }
+		for i in stride(from: 0, to: 1000, by: 1) {
+			new.insert(200_000 + i, at: i * 97)
+		}
+		new.swapAt(10, 90_000)
+		var a = Snapshot(), b = Snapshot()
+		a.appendSection("s", items: old)
+		b.appendSection("s", items: new)
+		measure {
+			_ = a.changes(to: b)
+		}
+	}
+
+	public func testPerformanceMyers() {
+		let old = (0..<100_000).map { $0 % 1000 }
+		var new = old
+		for i in stride(from: 0, to: new.count, by: 1000) {
+			new[i] = -1
+		}
+		measure {
+			_ = MMMDiff.myers(old, new)
+		}
+	}
+}
@@ -0,0 +1,103 @@
+//
+// MMMCommonUI. Part of MMMTemple.
+// Copyright (C) 2016-2020 MediaMonks. All rights reserved.
+//
+
+import MMMCommonUI
+import XCTest
+
+class MMMViewReusePoolTestCase: XCTestCase {
+
+	private class CardView: UIView {}
+	private class FancyCardView: CardView {}
+
+	public func testBasics() {
+
+		let pool = MMMViewReusePool(maxIdleViews: 2)
+		pool.register(CardView.self, shape: "small") { CardView() }
+		pool.register(CardView.self, shape: "large") { CardView() }
+
+		let a = pool.dequeue(CardView.self, shape: "small")
+		let b = pool.dequeue(CardView.self, shape: "small")
+		let c = pool.dequeue(CardView.self, shape: "small")
+		XCTAssertEqual(pool.numberOfCreatedViews, 3)
+
+		let superview = UIView()
+		superview.addSubview(a)
+		pool.enqueue(a, shape: "small")
+		XCTAssertNil(a.superview)
+		pool.enqueue(b, shape: "small")
+		// Above the cap.
+		pool.enqueue(c, shape: "small")
+		XCTAssertEqual(pool.numberOfDroppedViews, 1)
+		XCTAssertEqual(pool.numberOfIdleViews(of: CardView.self, shape: "small"), 2)
+
+		// Shapes are not mixed.
+		XCTAssert(pool.dequeue(CardView.self, shape: "large") !== b)
+		XCTAssert(pool.dequeue(CardView.self, shape: "small") === b)
+		XCTAssertEqual(pool.numberOfReusedViews, 1)
+
+		pool.prewarm(CardView.self, shape: "large", count: 10)
+		XCTAssertEqual(pool.numberOfIdleViews(of: CardView.self, shape: "large"), 2)
+
+		pool.removeAllIdleViews()
+		XCTAssertEqual(pool.numberOfIdleViews(of: CardView.self, shape: "large"), 0)
+	}
+
+	public func testFactoryReturningSubclass() {
+
+		let pool = MMMViewReusePool(maxIdleViews: 2)
+		pool.register(CardView.self, shape: "small") { FancyCardView() }
+
+		let a = pool.dequeue(CardView.self, shape: "small")
+		XCTAssert(a is FancyCardView)
+		pool.enqueue(a, shape: "small")
+
+		// Back into the bucket of the registered class.
+		XCTAssertEqual(pool.numberOfIdleViews(of: CardView.self, shape: "small"), 1)
+		XCTAssert(pool.dequeue(CardView.self, shape: "small") === a)
+		XCTAssertEqual(pool.numberOfCreatedViews, 1)
+	}
+
+	public func testSwap() {
+
+		let label = UILabel()
+		let cell = MMMViewWrappingCell<UIView>(view: label, reuseIdentifier: "cell")
+		let newView = UIView()
+		let old = cell.swapWrappedView(newView)
+		XCTAssert(old === label)
+		XCTAssertNil(label.superview)
+		XCTAssert(newView.superview === cell.contentView)
+		XCTAssert(cell.wrappedView === newView)
+
+		// Exactly one set of edge constraints for the new view.
+		let constraints = cell.contentView.constraints.filter { $0.firstItem === newView || $0.secondItem === newView }
+		XCTAssertEqual(constraints.count, 4)
+	}
+
+	public func testChurnPerformance() {
+
+		let pool = MMMViewReusePool(maxIdleViews: 8)
+		let shapes = (0..<5).map { "shape\($0)" }
+		for shape in shapes {
+			pool.register(CardView.self, shape: shape) { CardView() }
+			pool.prewarm(CardView.self, shape: shape, count: 8)
+		}
+
+		measure {
+			// Like scrolling through a feed: ~10 views on screen, one in, one out.
+			var visible: [(UIView, String)] = []
+			for i in 0..<20_000 {
+				let shape = shapes[(i * 7) % shapes.count]
+				visible.append((pool.dequeue(CardView.self, shape: shape), shape))
+				if visible.count > 10 {
+					let (view, shape) = visible.removeFirst()
+					pool.enqueue(view, shape: shape)
+				}
+			}
+			for (view, shape) in visible {
+				pool.enqueue(view, shape: shape)
+			}
+		}
+	}
+}